@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "kaAlgorithm.hh"
+
+
+// check the parallel algorithms against sequential loops
+
+
+int main(int ac, char** av)
+{
+  ka::linearWork::toRemove::initialize();
+
+  const size_t n = 1024 * 1024;
+  unsigned long* const x = (unsigned long*)malloc(n * sizeof(unsigned long));
+  unsigned long* const y = (unsigned long*)malloc(n * sizeof(unsigned long));
+  for (size_t i = 0; i < n; ++i) x[i] = rand() % 100;
+
+  unsigned int nerr = 0;
+
+  // for_each, transform
+  ka::for_each(y, y + n, [](unsigned long& v) { v = 1; });
+  ka::transform(x, x + n, y, [](unsigned long v) { return v * 2; });
+  for (size_t i = 0; i < n; ++i)
+    if (y[i] != x[i] * 2) { ++nerr; break ; }
+
+  // transform_reduce
+  unsigned long sum_seq = 0;
+  for (size_t i = 0; i < n; ++i) sum_seq += x[i] * x[i];
+  const unsigned long sum_par = ka::transform_reduce
+    (x, x + n, 0UL,
+     [](unsigned long a, unsigned long b) { return a + b; },
+     [](unsigned long v) { return v * v; });
+  if (sum_seq != sum_par) ++nerr;
+
+  // inclusive_scan
+  ka::inclusive_scan
+    (x, x + n, y, [](unsigned long a, unsigned long b) { return a + b; });
+  for (size_t i = 0, sum = 0; i < n; ++i)
+  {
+    sum += x[i];
+    if (y[i] != sum) { ++nerr; break ; }
+  }
+
+  // find_if, early exit
+  x[n / 3] = 1000;
+  x[n / 2] = 1000;
+  if (ka::find_if(x, x + n, [](unsigned long v) { return v == 1000; })
+      != x + n / 3) ++nerr;
+  if (ka::any_of(x, x + n, [](unsigned long v) { return v > 1000; }))
+    ++nerr;
+  if (ka::all_of(x, x + n, [](unsigned long v) { return v <= 1000; })
+      == false) ++nerr;
+
+  // early exit timing, match at the front vs no match
+  uint64_t start = kaapi_get_elapsedns();
+  for (unsigned int iter = 0; iter < 100; ++iter)
+    ka::any_of(x, x + n, [](unsigned long v) { return v == 1000; });
+  uint64_t stop = kaapi_get_elapsedns();
+  const double hit_time = (double)(stop - start) / (100 * 1E6);
+
+  start = kaapi_get_elapsedns();
+  for (unsigned int iter = 0; iter < 100; ++iter)
+    ka::any_of(x, x + n, [](unsigned long v) { return v == 1001; });
+  stop = kaapi_get_elapsedns();
+  const double miss_time = (double)(stop - start) / (100 * 1E6);
+
+  printf("%u %lf %lf %u\n", kaapi_getconcurrency(), hit_time, miss_time, nerr);
+
+  free(x);
+  free(y);
+
+  ka::linearWork::toRemove::finalize();
+
+  return 0;
+}
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "batch.hh"
+#include "random.hh"
+
+
+// many random polynoms at many points, tiled against a horner
+// per pair
+
+
+static double* make_rand_polynoms(unsigned long n, unsigned long np)
+{
+  double* const a = (double*)malloc(np * (n + 1) * sizeof(double));
+
+  random_fill_par(a, np * (n + 1), 0, randomUniform(-0.5, 0.5));
+
+  return a;
+}
+
+int main(int ac, char** av)
+{
+  static const unsigned long n = 255;
+  static const unsigned long np = 2048;
+  static const unsigned long m = 2048;
+
+  ka::linearWork::toRemove::initialize();
+
+  double* const a = make_rand_polynoms(n, np);
+
+  double* const x = (double*)malloc(m * sizeof(double));
+  for (unsigned long k = 0; k < m; ++k)
+    x[k] = 2. * (double)rand() / RAND_MAX - 1.;
+
+  double* const res = (double*)malloc(np * m * sizeof(double));
+  double* const ref = (double*)malloc(np * m * sizeof(double));
+
+  uint64_t start = kaapi_get_elapsedns();
+  batch_par<doubleField>(a, n, np, x, m, res);
+  uint64_t stop = kaapi_get_elapsedns();
+  const double par_time = (double)(stop - start) / 1E6;
+
+  start = kaapi_get_elapsedns();
+  batch_seq<doubleField>(a, n, np, x, m, ref);
+  stop = kaapi_get_elapsedns();
+  const double seq_time = (double)(stop - start) / 1E6;
+
+  unsigned long nerr = 0;
+  for (unsigned long i = 0; i < np * m; ++i)
+    if (fabs(res[i] - ref[i]) > 1E-9 * (1. + fabs(ref[i]))) ++nerr;
+
+  // odd sizes, partial tiles
+  {
+    static const unsigned long pn = 1001;
+    static const unsigned long pm = 37;
+    static const unsigned long pnp = 21;
+
+    unsigned long* const pa = (unsigned long*)
+      malloc(pnp * (pn + 1) * sizeof(unsigned long));
+    for (unsigned long i = 0; i < pnp * (pn + 1); ++i) pa[i] = modp(rand());
+
+    unsigned long px[pm];
+    for (unsigned long k = 0; k < pm; ++k) px[k] = modp(rand());
+
+    unsigned long pres[pnp * pm];
+    unsigned long pref[pnp * pm];
+    batch_par<modpField>(pa, pn, pnp, px, pm, pres);
+    batch_seq<modpField>(pa, pn, pnp, px, pm, pref);
+
+    for (unsigned long i = 0; i < pnp * pm; ++i)
+      if (pres[i] != pref[i]) ++nerr;
+
+    free(pa);
+  }
+
+  printf("%u %lf %lf %lu\n", kaapi_getconcurrency(), par_time, seq_time, nerr);
+
+  ka::linearWork::toRemove::finalize();
+
+  free(ref);
+  free(res);
+  free(x);
+  free(a);
+
+  return 0;
+}
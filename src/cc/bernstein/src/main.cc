@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "bernstein.hh"
+
+
+// batched bezier evaluation, de casteljau against the O(n) scheme
+
+
+static double* make_rand_array(unsigned long n)
+{
+  double* const a = (double*)malloc(n * sizeof(double));
+  for (unsigned long i = 0; i < n; ++i) a[i] = (double)rand() / RAND_MAX;
+  return a;
+}
+
+static double max_err
+(double* const* lhs, double* const* rhs, unsigned int dim, unsigned long n)
+{
+  double err = 0.;
+  for (unsigned int d = 0; d < dim; ++d)
+    for (unsigned long j = 0; j < n; ++j)
+      err = fmax(err, fabs(lhs[d][j] - rhs[d][j]));
+  return err;
+}
+
+int main(int ac, char** av)
+{
+  static const unsigned int dim = 3;
+  static const unsigned long n = 16;
+  static const unsigned long nt = 1024 * 1024;
+
+  ka::linearWork::toRemove::initialize();
+
+  double* ctrl[dim];
+  double* out_dc[dim];
+  double* out_h[dim];
+  for (unsigned int d = 0; d < dim; ++d)
+  {
+    ctrl[d] = make_rand_array((n + 1) * (n + 1));
+    out_dc[d] = (double*)malloc(nt * sizeof(double));
+    out_h[d] = (double*)malloc(nt * sizeof(double));
+  }
+
+  double* const t = make_rand_array(nt);
+  double* const v = make_rand_array(nt);
+
+  // curves
+  uint64_t start = kaapi_get_elapsedns();
+  bezier_curve_par(ctrl, dim, n, t, nt, out_dc, true);
+  uint64_t stop = kaapi_get_elapsedns();
+  const double dc_time = (double)(stop - start) / 1E6;
+
+  start = kaapi_get_elapsedns();
+  bezier_curve_par(ctrl, dim, n, t, nt, out_h, false);
+  stop = kaapi_get_elapsedns();
+  const double h_time = (double)(stop - start) / 1E6;
+
+  const double curve_err = max_err(out_dc, out_h, dim, nt);
+
+  // patches, checked against de casteljau on rows then column
+  static const unsigned long np = 1024 * 64;
+
+  start = kaapi_get_elapsedns();
+  bezier_patch_par(ctrl, dim, n, n, t, v, np, out_h);
+  stop = kaapi_get_elapsedns();
+  const double patch_time = (double)(stop - start) / 1E6;
+
+  double* const tmp = (double*)malloc
+    ((n + 1) * bernstein_block_size * sizeof(double));
+  double col[n + 1];
+  for (unsigned int d = 0; d < dim; ++d)
+    for (unsigned long j = 0; j < np; ++j)
+    {
+      for (unsigned long i = 0; i <= n; ++i)
+	de_casteljau_block(ctrl[d] + i * (n + 1), n, v + j, 1, col + i, tmp);
+      de_casteljau_block(col, n, t + j, 1, out_dc[d] + j, tmp);
+    }
+  free(tmp);
+
+  const double patch_err = max_err(out_dc, out_h, dim, np);
+
+  printf("%u %lf %lf %lf %e %e\n", kaapi_getconcurrency(),
+	 dc_time, h_time, patch_time, curve_err, patch_err);
+
+  for (unsigned int d = 0; d < dim; ++d)
+  {
+    free(ctrl[d]);
+    free(out_dc[d]);
+    free(out_h[d]);
+  }
+  free(t);
+  free(v);
+
+  ka::linearWork::toRemove::finalize();
+
+  return 0;
+}
@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "deflate.hh"
+#include "random.hh"
+
+
+// parallel synthetic division of a random modp polynom
+
+
+static unsigned long* make_rand_polynom(unsigned long n)
+{
+  unsigned long* const a = (unsigned long*)malloc
+    ((n + 1) * sizeof(unsigned long));
+
+  random_fill_par(a, n + 1, 0, randomModulo<unsigned long>(modp_p));
+
+  return a;
+}
+
+int main(int ac, char** av)
+{
+  static const unsigned long n = 1024 * 1024;
+  static const unsigned long c = 2;
+
+  ka::linearWork::toRemove::initialize();
+
+  unsigned long* const a = make_rand_polynom(n);
+
+  unsigned long* const q_seq = (unsigned long*)
+    malloc(n * sizeof(unsigned long));
+  unsigned long* const q_par = (unsigned long*)
+    malloc(n * sizeof(unsigned long));
+
+  const unsigned long r_seq = deflate_seq<modpField>(c, a, n, q_seq);
+
+  uint64_t start = kaapi_get_elapsedns();
+
+  unsigned long r_par = 0;
+  for (unsigned int iter = 0; iter < 100; ++iter)
+    r_par = deflate_par<modpField>(c, a, n, q_par);
+
+  uint64_t stop = kaapi_get_elapsedns();
+  double par_time = (double)(stop - start) / (100 * 1E6);
+
+  unsigned long nerr = 0;
+  for (unsigned long i = 0; i < n; ++i)
+    if (q_seq[i] != q_par[i]) ++nerr;
+  if (r_seq != r_par) ++nerr;
+
+  printf("%u %lf %lu\n", kaapi_getconcurrency(), par_time, nerr);
+
+  ka::linearWork::toRemove::finalize();
+
+  free(q_par);
+  free(q_seq);
+  free(a);
+
+  return 0;
+}
@@ -0,0 +1,15 @@
+#!/usr/bin/env sh
+
+XKAAPI_DIR="$HOME/install/xkaapi_master"
+
+# one worker per group of 12 cores
+
+for p in 1 2 4; do
+    CPUSETS=""
+    for k in `seq 0 $(($p - 1))`; do
+	CPUSET="$(($k * 12)):$(($k * 12 + 11))"
+	CPUSETS="${CPUSETS:+$CPUSETS/}$CPUSET"
+    done
+    LD_LIBRARY_PATH=$XKAAPI_DIR/lib:$LD_LIBRARY_PATH \
+    ./dist -p $p -c $CPUSETS ;
+done
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "dist.hh"
+#include "random.hh"
+
+
+// multi process horner evaluation of a modp polynom.
+//
+// usage: dist [-p nprocs] [-c cpuset[/cpuset...]] [-f file]
+// -p: number of worker processes
+// -c: KAAPI_CPUSET of each worker, eg. 0:11/12:23 to run one
+// worker per numa node
+// -f: coefficients file, n + 1 native unsigned longs. values
+// out of the field are reduced into a shared memory copy. a
+// random polynom in a shared memory object otherwise
+//
+// output: nprocs time check, then the time of each worker.
+
+
+static const unsigned int max_nprocs = 64;
+
+// the coordinator does not run the runtime, sequential fill
+static void make_rand_polynom(unsigned long* a, unsigned long n)
+{
+  random_fill_seq(a, n + 1, 0, randomModulo<unsigned long>(modp_p));
+}
+
+static unsigned int split_cpusets(char* s, const char** cpusets)
+{
+  unsigned int n = 0;
+  for (char* p = strtok(s, "/"); p && n < max_nprocs; p = strtok(NULL, "/"))
+    cpusets[n++] = p;
+  return n;
+}
+
+int main(int ac, char** av)
+{
+  static const unsigned long x = 2;
+
+  unsigned int nprocs = 2;
+  const char* path = NULL;
+
+  const char* cpusets[max_nprocs];
+  unsigned int ncpusets = 0;
+
+  int opt;
+  while ((opt = getopt(ac, av, "p:c:f:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'p':
+      nprocs = (unsigned int)atoi(optarg);
+      if (nprocs == 0 || nprocs > max_nprocs) goto on_usage;
+      break ;
+
+    case 'c':
+      ncpusets = split_cpusets(optarg, cpusets);
+      break ;
+
+    case 'f':
+      path = optarg;
+      break ;
+
+    default:
+      goto on_usage;
+    }
+  }
+
+  if (optind != ac) goto on_usage;
+  if (ncpusets && ncpusets != nprocs) goto on_usage;
+
+  {
+    char name[64];
+    distSource src;
+    sharedPolynom shm;
+    mappedFile file;
+    const unsigned long* a;
+    unsigned long n;
+
+    if (path != NULL)
+    {
+      if (file.open(path) == -1)
+      {
+	fprintf(stderr, "%s: %s\n", path, strerror(errno));
+	return -1;
+      }
+
+      if (file.size() < 2 * sizeof(unsigned long))
+      {
+	fprintf(stderr, "%s: not a polynom\n", path);
+	return -1;
+      }
+
+      a = (const unsigned long*)file.data();
+      n = file.size() / sizeof(unsigned long) - 1;
+
+      src._name = path;
+      src._is_file = true;
+    }
+    else
+    {
+      n = 16 * 1024 * 1024;
+    }
+
+    // the workers evaluate reduced coefficients only, the
+    // modp products overflow otherwise
+    unsigned long i = 0;
+    if (path != NULL) while (i <= n && modp(a[i]) == a[i]) ++i;
+
+    if (path == NULL || i <= n)
+    {
+      snprintf(name, sizeof(name), "/horner.%d", (int)getpid());
+
+      if (shm.create(name, n) == -1)
+      {
+	fprintf(stderr, "%s: %s\n", name, strerror(errno));
+	return -1;
+      }
+
+      if (path == NULL) make_rand_polynom(shm._a, n);
+      else for (i = 0; i <= n; ++i) shm._a[i] = modp(a[i]);
+
+      a = shm._a;
+
+      src._name = name;
+      src._is_file = false;
+    }
+
+    distMessage msgs[max_nprocs];
+    unsigned long res = 0;
+
+    const uint64_t start = dist_elapsedns();
+    const int err = dist_horner
+      (src, x, n, nprocs, ncpusets ? cpusets : NULL, res, msgs);
+    const uint64_t stop = dist_elapsedns();
+
+    if (src._is_file == false) sharedPolynom::unlink(name);
+
+    if (err == -1)
+    {
+      fprintf(stderr, "dist_horner: failed\n");
+      return -1;
+    }
+
+    const unsigned long ref = horner_seq<modpField>(x, a, n);
+
+    printf("%u %lf %lu == %lu\n", nprocs,
+	   (double)(stop - start) / 1E6, res, ref);
+
+    for (unsigned int k = 0; k < nprocs; ++k)
+      printf("  %u [%lu, %lu[ %lf\n", k,
+	     (unsigned long)msgs[k]._i, (unsigned long)msgs[k]._j,
+	     (double)msgs[k]._ns / 1E6);
+  }
+
+  return 0;
+
+ on_usage:
+  fprintf(stderr, "usage: %s [-p nprocs] [-c cpuset[/cpuset...]] [-f file]\n", av[0]);
+  return -1;
+}
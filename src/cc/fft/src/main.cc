@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <complex>
+#include "multipoint.hh"
+#include "random.hh"
+
+
+// evaluation of a random real polynom at the N roots of unity,
+// by fft and by the multi point horner
+
+
+static double* make_rand_polynom(unsigned long n)
+{
+  double* const a = (double*)malloc((n + 1) * sizeof(double));
+
+  random_fill_par(a, n + 1, 0, randomUniform(-0.5, 0.5));
+
+  return a;
+}
+
+int main(int ac, char** av)
+{
+  typedef std::complex<double> complex_type;
+
+  static const unsigned long n = 1024 * 1024;
+  static const unsigned long N = 64 * 1024;
+
+  // horner reference on a few points only
+  static const unsigned long nchecks = 64;
+
+  ka::linearWork::toRemove::initialize();
+
+  double* const a = make_rand_polynom(n);
+
+  complex_type* const x = (complex_type*)malloc(N * sizeof(complex_type));
+  for (unsigned long k = 0; k < N; ++k)
+  {
+    const double t = 2. * M_PI * (double)k / (double)N;
+    x[k] = complex_type(cos(t), sin(t));
+  }
+
+  complex_type* const res = (complex_type*)malloc(N * sizeof(complex_type));
+
+  uint64_t start = kaapi_get_elapsedns();
+  multipoint_par<complexField>(x, N, a, n, res);
+  uint64_t stop = kaapi_get_elapsedns();
+  const double fft_time = (double)(stop - start) / 1E6;
+
+  complex_type ref[nchecks];
+  complex_type xs[nchecks];
+  for (unsigned long j = 0; j < nchecks; ++j) xs[j] = x[(j * 997) % N];
+
+  // not roots of unity in order, horner
+  start = kaapi_get_elapsedns();
+  multipoint_par<complexField>(xs, nchecks, a, n, ref);
+  stop = kaapi_get_elapsedns();
+  const double horner_time = (double)(stop - start) / 1E6;
+
+  unsigned long nerr = 0;
+  for (unsigned long j = 0; j < nchecks; ++j)
+  {
+    const complex_type r = res[(j * 997) % N];
+    if (std::abs(r - ref[j]) > 1E-6 * (1. + std::abs(ref[j]))) ++nerr;
+  }
+
+  printf("%u %lf %lf %lu\n", kaapi_getconcurrency(),
+	 fft_time, horner_time * (double)N / nchecks, nerr);
+
+  ka::linearWork::toRemove::finalize();
+
+  free(res);
+  free(x);
+  free(a);
+
+  return 0;
+}
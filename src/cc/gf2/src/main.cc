@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "gf2.hh"
+
+
+// binary field horner evaluation
+
+
+static uint64_t rand64()
+{
+  return ((uint64_t)rand() << 62) ^ ((uint64_t)rand() << 31) ^ rand();
+}
+
+template<typename field_type>
+static unsigned int check_field
+(typename field_type::value_type a, typename field_type::value_type b,
+ typename field_type::value_type c)
+{
+  // associativity, commutativity, distributivity
+  unsigned int nerr = 0;
+  if (field_type::mul(field_type::mul(a, b), c) !=
+      field_type::mul(a, field_type::mul(b, c))) ++nerr;
+  if (field_type::mul(a, b) != field_type::mul(b, a)) ++nerr;
+  if (field_type::mul(a, field_type::add(b, c)) !=
+      field_type::add(field_type::mul(a, b), field_type::mul(a, c))) ++nerr;
+  return nerr;
+}
+
+int main(int ac, char** av)
+{
+  static const unsigned long n = 8 * 1024 * 1024;
+
+  ka::linearWork::toRemove::initialize();
+
+  unsigned int nerr = 0;
+
+  // field properties. a^(2^k - 1) = 1, a^(2^128) = a
+  for (unsigned int i = 0; i < 100; ++i)
+  {
+    const uint64_t a = rand64() | 1, b = rand64(), c = rand64();
+    nerr += check_field<gf2_64Field>(a, b, c);
+    nerr += check_field<gf2_128Field>(gf128(a, c), gf128(b, a), gf128(c, b));
+    nerr += check_field<gf2_8Field>(a, b, c);
+
+    if (gf2_64Field::pow(a, ~0UL) != 1) ++nerr;
+    if (gf2_8Field::pow((uint8_t)a, 255) != 1) ++nerr;
+
+    gf128 s(a, b);
+    for (unsigned int k = 0; k < 128; ++k) s = gf2_128Field::mul(s, s);
+    if (s != gf128(a, b)) ++nerr;
+  }
+
+  // GF(2^64) polynom of degree n
+  uint64_t* const a = (uint64_t*)malloc((n + 1) * sizeof(uint64_t));
+  for (unsigned long i = 0; i <= n; ++i) a[i] = rand64();
+  const uint64_t x = rand64();
+
+  // reference, single chain
+  uint64_t ref = a[0];
+  for (unsigned long i = 1; i <= n; ++i) ref = gf2_64Field::axb(ref, x, a[i]);
+
+  if (horner_seq<gf2_64Field>(x, a, n) != ref) ++nerr;
+
+  uint64_t start = kaapi_get_elapsedns();
+
+  uint64_t res = 0;
+  for (unsigned int iter = 0; iter < 10; ++iter)
+    res = horner_par<gf2_64Field>(x, a, n);
+
+  uint64_t stop = kaapi_get_elapsedns();
+  const double par_time = (double)(stop - start) / (10 * 1E6);
+  const double gbps = (double)((n + 1) * sizeof(uint64_t)) / (par_time * 1E6);
+
+  if (res != ref) ++nerr;
+
+  // GF(2^8), byte coefficients
+  uint8_t* const b = (uint8_t*)a;
+  uint8_t ref8 = b[0];
+  for (unsigned long i = 1; i <= n; ++i)
+    ref8 = gf2_8Field::axb(ref8, (uint8_t)x, b[i]);
+  if (horner_par<gf2_8Field>((uint8_t)x, b, n) != ref8) ++nerr;
+
+  printf("%u %lf %lf %u\n", kaapi_getconcurrency(), par_time, gbps, nerr);
+
+  free(a);
+
+  ka::linearWork::toRemove::finalize();
+
+  return 0;
+}
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "mappedFile.hh"
+#include "rabinKarp.hh"
+
+
+// multi pattern fixed string search in a file.
+//
+// usage: rkgrep [-v] [-c] [-t] file pattern...
+// -c: only print the match count
+// -v: print the search time and throughput on stderr
+// -t: check against a naive memmem scan, print the number of
+// differing matches on stderr
+//
+// output: one "offset pattern" line per match, sorted by offset.
+
+
+int main(int ac, char** av)
+{
+  bool is_count = false;
+  bool is_verbose = false;
+  bool is_check = false;
+
+  int err = 0;
+
+  int opt;
+  while ((opt = getopt(ac, av, "vct")) != -1)
+  {
+    switch (opt)
+    {
+    case 'v': is_verbose = true; break ;
+    case 'c': is_count = true; break ;
+    case 't': is_check = true; break ;
+    default: goto on_usage;
+    }
+  }
+
+  if (optind + 2 > ac) goto on_usage;
+
+  {
+    mappedFile file;
+    if (file.open(av[optind]) == -1)
+    {
+      fprintf(stderr, "%s: %s\n", av[optind], strerror(errno));
+      return -1;
+    }
+
+    const unsigned int npatterns = (unsigned int)(ac - optind - 1);
+    const unsigned char** const patterns = (const unsigned char**)
+      malloc(npatterns * sizeof(const unsigned char*));
+    size_t* const lens = (size_t*)malloc(npatterns * sizeof(size_t));
+    for (unsigned int i = 0; i < npatterns; ++i)
+    {
+      patterns[i] = (const unsigned char*)av[optind + 1 + i];
+      lens[i] = strlen(av[optind + 1 + i]);
+    }
+
+    ka::linearWork::toRemove::initialize();
+
+    const uint64_t start = kaapi_get_elapsedns();
+
+    rkPatterns rk(patterns, lens, npatterns);
+    rkMatch* matches = NULL;
+    const uint64_t count = rabin_karp_par
+      (file.data(), file.size(), rk, is_count ? NULL : &matches);
+
+    const uint64_t stop = kaapi_get_elapsedns();
+
+    if (is_check)
+    {
+      rkMatch* ref_matches = NULL;
+      const uint64_t ref_count = rabin_karp_seq
+	(file.data(), file.size(), rk, is_count ? NULL : &ref_matches);
+
+      uint64_t nerr = count > ref_count ? count - ref_count : ref_count - count;
+      if (is_count == false)
+      {
+	const uint64_t n = count < ref_count ? count : ref_count;
+	for (uint64_t i = 0; i < n; ++i)
+	  if (matches[i]._offset != ref_matches[i]._offset ||
+	      matches[i]._pattern != ref_matches[i]._pattern) ++nerr;
+	free(ref_matches);
+      }
+
+      fprintf(stderr, "%lu\n", (unsigned long)nerr);
+      if (nerr) err = -1;
+    }
+
+    if (is_count)
+    {
+      printf("%lu\n", (unsigned long)count);
+    }
+    else
+    {
+      for (uint64_t i = 0; i < count; ++i)
+	printf("%lu %s\n", (unsigned long)matches[i]._offset,
+	       av[optind + 1 + matches[i]._pattern]);
+      free(matches);
+    }
+
+    if (is_verbose)
+    {
+      const double secs = (double)(stop - start) / 1E9;
+      fprintf(stderr, "%u %lf %lf\n", kaapi_getconcurrency(), secs * 1E3,
+	      (double)file.size() / (secs * 1E9));
+    }
+
+    ka::linearWork::toRemove::finalize();
+
+    free(lens);
+    free(patterns);
+  }
+
+  return err;
+
+ on_usage:
+  fprintf(stderr, "usage: %s [-v] [-c] [-t] file pattern...\n", av[0]);
+  return -1;
+}
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "mappedFile.hh"
+#include "polyHash.hh"
+
+
+// polynomial hash of a file, modulo 2^61 - 1.
+//
+// usage: hash [-v] [-c] [-k nbases] [-p len:h0[,h1...]] file
+// -k: number of independent bases, at most 4
+// -p: the state of the previous len bytes, one hash per base.
+// the file is hashed from the offset len and the state is
+// extended, so appended data is rehashed without reading the
+// prefix again.
+// -v: print the hashing time and throughput on stderr
+// -c: check against the sequential hash, print the number of
+// differing hashes on stderr
+//
+// output: len h0 [h1...], hashes in hexadecimal.
+
+
+// returns the number of hashes, -1 on error or if a hash
+// is not below 2^61 - 1
+
+static int parse_state(const char* s, polyHashState& state)
+{
+  char* end;
+
+  state.initialize();
+
+  state._len = strtoull(s, &end, 10);
+  if (*end != ':') return -1;
+
+  for (unsigned int k = 0; k < poly_hash_max_bases; ++k)
+  {
+    s = end + 1;
+    state._h[k] = strtoull(s, &end, 16);
+    if (end == s) return -1;
+
+    // hashes are reduced, the field assumes it
+    if (state._h[k] >= mersenne61Field::prime) return -1;
+    if (*end == 0) return (int)k + 1;
+    if (*end != ',') return -1;
+  }
+
+  return -1;
+}
+
+int main(int ac, char** av)
+{
+  unsigned int nbases = 1;
+  bool is_verbose = false;
+  bool is_check = false;
+
+  // hashes given by -p, 0 if none
+  int nstate = 0;
+
+  int err = 0;
+
+  polyHashState state;
+  state.initialize();
+
+  int opt;
+  while ((opt = getopt(ac, av, "vck:p:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'v':
+      is_verbose = true;
+      break ;
+
+    case 'c':
+      is_check = true;
+      break ;
+
+    case 'k':
+      nbases = (unsigned int)atoi(optarg);
+      if (nbases == 0 || nbases > poly_hash_max_bases) goto on_usage;
+      break ;
+
+    case 'p':
+      nstate = parse_state(optarg, state);
+      if (nstate == -1) goto on_usage;
+      break ;
+
+    default:
+      goto on_usage;
+    }
+  }
+
+  if (optind + 1 != ac) goto on_usage;
+
+  // a missing hash would silently resume from 0
+  if (nstate && nstate != (int)nbases)
+  {
+    fprintf(stderr, "%d hashes in the previous state, %u bases\n", nstate, nbases);
+    return -1;
+  }
+
+  {
+    mappedFile file;
+    if (file.open(av[optind]) == -1)
+    {
+      fprintf(stderr, "%s: %s\n", av[optind], strerror(errno));
+      return -1;
+    }
+
+    if (state._len > file.size())
+    {
+      fprintf(stderr, "%s: shorter than the previous state\n", av[optind]);
+      return -1;
+    }
+
+    ka::linearWork::toRemove::initialize();
+
+    const polyHashState prefix = state;
+
+    const uint64_t start = kaapi_get_elapsedns();
+
+    poly_hash_extend
+      (state, file.data() + state._len, file.size() - state._len, nbases);
+
+    const uint64_t stop = kaapi_get_elapsedns();
+
+    printf("%lu", (unsigned long)state._len);
+    for (unsigned int k = 0; k < nbases; ++k)
+      printf(" %016lx", (unsigned long)state._h[k]);
+    printf("\n");
+
+    if (is_check)
+    {
+      // the previous state extended by the sequential hash
+      polyHashState check = prefix;
+
+      polyHashState suffix;
+      poly_hash_seq
+	(suffix, file.data() + prefix._len, file.size() - prefix._len, nbases);
+      poly_hash_concat(check, suffix, nbases);
+
+      unsigned int nerr = 0;
+      for (unsigned int k = 0; k < nbases; ++k)
+	if (check._h[k] != state._h[k]) ++nerr;
+      if (check._len != state._len) ++nerr;
+
+      fprintf(stderr, "%u\n", nerr);
+      if (nerr) err = -1;
+    }
+
+    if (is_verbose)
+    {
+      const double secs = (double)(stop - start) / 1E9;
+      fprintf(stderr, "%u %lf %lf\n", kaapi_getconcurrency(), secs * 1E3,
+	      (double)file.size() / (secs * 1E9));
+    }
+
+    ka::linearWork::toRemove::finalize();
+  }
+
+  return err;
+
+ on_usage:
+  fprintf(stderr, "usage: %s [-v] [-c] [-k nbases] [-p len:h0[,h1...]] file\n", av[0]);
+  return -1;
+}
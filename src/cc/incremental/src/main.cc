@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "incremental.hh"
+#include "random.hh"
+
+
+// incremental reevaluation of a random polynom under batches of
+// coefficient updates, against full multi point reevaluations
+
+
+static unsigned long* make_rand_polynom(unsigned long n)
+{
+  unsigned long* const a = (unsigned long*)malloc
+    ((n + 1) * sizeof(unsigned long));
+
+  random_fill_par(a, n + 1, 0, randomModulo<unsigned long>(modp_p));
+
+  return a;
+}
+
+int main(int ac, char** av)
+{
+  static const unsigned long n = 4 * 1024 * 1024;
+  static const unsigned long m = 256;
+  static const unsigned long nbatches = 100;
+  static const unsigned long batch_size = 16;
+
+  ka::linearWork::toRemove::initialize();
+
+  unsigned long* const a = make_rand_polynom(n);
+
+  unsigned long* const x = (unsigned long*)malloc(m * sizeof(unsigned long));
+  for (unsigned long j = 0; j < m; ++j) x[j] = modp(rand());
+
+  unsigned long indices[batch_size];
+  unsigned long coefs[batch_size];
+
+  incrementalEval<modpField> eval(a, n, x, m);
+
+  uint64_t start = kaapi_get_elapsedns();
+
+  for (unsigned long k = 0; k < nbatches; ++k)
+  {
+    for (unsigned long u = 0; u < batch_size; ++u)
+    {
+      indices[u] = (unsigned long)rand() % (n + 1);
+      coefs[u] = modp(rand());
+    }
+    eval.update(indices, coefs, batch_size);
+  }
+
+  uint64_t stop = kaapi_get_elapsedns();
+  const double update_time = (double)(stop - start) / (nbatches * 1E6);
+
+  // a full reevaluation per batch otherwise
+  unsigned long* const ref = (unsigned long*)malloc(m * sizeof(unsigned long));
+
+  start = kaapi_get_elapsedns();
+  multipoint_par<modpField>(x, m, a, n, ref);
+  stop = kaapi_get_elapsedns();
+  const double rebuild_time = (double)(stop - start) / 1E6;
+
+  unsigned long nerr = 0;
+  for (unsigned long j = 0; j < m; ++j)
+    if (eval.values()[j] != ref[j]) ++nerr;
+
+  // double polynom, single updates
+  {
+    static const unsigned long dn = 1024;
+    double* const da = (double*)malloc((dn + 1) * sizeof(double));
+    for (unsigned long i = 0; i <= dn; ++i) da[i] = (double)rand() / RAND_MAX;
+
+    double dx[4] = { 0.5, -0.75, 0.999, 1.001 };
+    incrementalEval<doubleField> deval(da, dn, dx, 4);
+
+    for (unsigned long k = 0; k < 100; ++k)
+      deval.update((unsigned long)rand() % (dn + 1), (double)rand() / RAND_MAX);
+
+    for (unsigned long j = 0; j < 4; ++j)
+    {
+      const double r = horner_seq<doubleField>(dx[j], da, dn);
+      if (fabs(deval.values()[j] - r) > 1E-9 * (1. + fabs(r))) ++nerr;
+    }
+
+    free(da);
+  }
+
+  printf("%u %lf %lf %lu\n", kaapi_getconcurrency(),
+	 update_time, rebuild_time, nerr);
+
+  ka::linearWork::toRemove::finalize();
+
+  free(ref);
+  free(x);
+  free(a);
+
+  return 0;
+}
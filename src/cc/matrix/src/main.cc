@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "matrixPoly.hh"
+
+
+// p(A) by paterson stockmeyer, against horner with matrix operands
+
+
+template<typename field_type>
+static unsigned long check
+(
+ unsigned long m, unsigned long n,
+ typename field_type::value_type (*rand_value)(),
+ double& ps_time, double& horner_time
+)
+{
+  typedef typename field_type::value_type value_type;
+
+  value_type* const A = (value_type*)malloc(m * m * sizeof(value_type));
+  for (unsigned long e = 0; e < m * m; ++e) A[e] = rand_value();
+
+  value_type* const a = (value_type*)malloc((n + 1) * sizeof(value_type));
+  for (unsigned long i = 0; i <= n; ++i) a[i] = rand_value();
+
+  value_type* const res = (value_type*)malloc(m * m * sizeof(value_type));
+  value_type* const ref = (value_type*)malloc(m * m * sizeof(value_type));
+
+  uint64_t start = kaapi_get_elapsedns();
+  matrix_poly_horner<field_type>(A, m, a, n, ref);
+  uint64_t stop = kaapi_get_elapsedns();
+  horner_time = (double)(stop - start) / 1E6;
+
+  // the powers are part of the timing
+  start = kaapi_get_elapsedns();
+  matrixPowers<field_type> powers(A, m);
+  matrix_poly_par<field_type>(powers, a, n, res);
+  stop = kaapi_get_elapsedns();
+  ps_time = (double)(stop - start) / 1E6;
+
+  double max = 0.;
+  for (unsigned long e = 0; e < m * m; ++e)
+    if (fabs((double)ref[e]) > max) max = fabs((double)ref[e]);
+
+  unsigned long nerr = 0;
+  for (unsigned long e = 0; e < m * m; ++e)
+    if (fabs((double)res[e] - (double)ref[e]) > 1E-9 * max) ++nerr;
+
+  // an other polynom on the cached powers
+  for (unsigned long i = 0; i <= n / 2; ++i) a[i] = rand_value();
+  matrix_poly_par<field_type>(powers, a, n / 2, res);
+  matrix_poly_horner<field_type>(A, m, a, n / 2, ref);
+  for (unsigned long e = 0; e < m * m; ++e)
+    if (fabs((double)res[e] - (double)ref[e]) > 1E-9 * max) ++nerr;
+
+  free(A);
+  free(a);
+  free(res);
+  free(ref);
+
+  return nerr;
+}
+
+// spectral radius below 1
+static double rand_double() { return ((double)rand() / RAND_MAX - 0.5) / 64.; }
+static unsigned long rand_modp() { return modp(rand()); }
+
+int main(int ac, char** av)
+{
+  static const unsigned long ns[] = { 20, 50, 100, 200 };
+  static const unsigned long m = 256;
+
+  ka::linearWork::toRemove::initialize();
+
+  for (unsigned int k = 0; k < sizeof(ns) / sizeof(ns[0]); ++k)
+  {
+    double ps_time, horner_time, modp_ps_time, modp_horner_time;
+    unsigned long nerr = 0;
+    nerr += check<doubleField>(m, ns[k], rand_double, ps_time, horner_time);
+    nerr += check<modpField>
+      (m / 4, ns[k], rand_modp, modp_ps_time, modp_horner_time);
+
+    printf("%u %lu %lf %lf %lu\n", kaapi_getconcurrency(), ns[k],
+	   ps_time, horner_time, nerr);
+  }
+
+  ka::linearWork::toRemove::finalize();
+
+  return 0;
+}
@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "multipoint.hh"
+#include "random.hh"
+
+
+// a random double polynom at a batch of points, in a single pass
+// over the coefficients against a horner per point
+
+
+static double* make_rand_polynom(unsigned long n)
+{
+  double* const a = (double*)malloc((n + 1) * sizeof(double));
+
+  random_fill_par(a, n + 1, 0, randomUniform(-0.5, 0.5));
+
+  return a;
+}
+
+int main(int ac, char** av)
+{
+  static const unsigned long n = 16 * 1024 * 1024;
+  static const unsigned long m = 67;
+
+  ka::linearWork::toRemove::initialize();
+
+  double* const a = make_rand_polynom(n);
+
+  // |x| <= 1, no overflow
+  double* const x = (double*)malloc(m * sizeof(double));
+  for (unsigned long k = 0; k < m; ++k)
+    x[k] = 2. * (double)rand() / RAND_MAX - 1.;
+
+  double* const res = (double*)malloc(m * sizeof(double));
+  double* const ref = (double*)malloc(m * sizeof(double));
+
+  uint64_t start = kaapi_get_elapsedns();
+  multipoint_par<doubleField>(x, m, a, n, res);
+  uint64_t stop = kaapi_get_elapsedns();
+  const double par_time = (double)(stop - start) / 1E6;
+
+  start = kaapi_get_elapsedns();
+  multipoint_seq<doubleField>(x, m, a, n, ref);
+  stop = kaapi_get_elapsedns();
+  const double seq_time = (double)(stop - start) / 1E6;
+
+  unsigned long nerr = 0;
+  for (unsigned long k = 0; k < m; ++k)
+    if (fabs(res[k] - ref[k]) > 1E-9 * (1. + fabs(ref[k]))) ++nerr;
+
+  printf("%u %lf %lf %lu\n", kaapi_getconcurrency(), par_time, seq_time, nerr);
+
+  ka::linearWork::toRemove::finalize();
+
+  free(ref);
+  free(res);
+  free(x);
+  free(a);
+
+  return 0;
+}
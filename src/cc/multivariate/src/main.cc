@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "multivariate.hh"
+
+
+// trivariate and 4 variate dense polynoms at a batch of points,
+// against the naive sum of monomials
+
+
+template<typename field_type>
+static typename field_type::value_type naive_eval
+(
+ const multivariatePolynom<field_type>& poly,
+ const typename field_type::value_type* const* x, unsigned long p
+)
+{
+  typedef typename field_type::value_type value_type;
+
+  value_type res = field_type::zero();
+
+  for (unsigned long k = 0; k < poly.size(); ++k)
+  {
+    // monomial of the tensor index k
+    value_type m = poly._a[k];
+    for (unsigned int v = 0; v < poly._nvars; ++v)
+    {
+      const unsigned long i = (k / poly._strides[v]) % (poly._n[v] + 1);
+      m = field_type::mul(m, field_type::pow(x[v][p], poly._n[v] - i));
+    }
+    res = field_type::add(res, m);
+  }
+
+  return res;
+}
+
+template<typename field_type>
+static unsigned long check
+(
+ unsigned int nvars, const unsigned long* n, unsigned long npoints,
+ typename field_type::value_type (*rand_value)(), double& par_time
+)
+{
+  typedef typename field_type::value_type value_type;
+
+  multivariatePolynom<field_type> poly;
+  poly.initialize(nvars, n, NULL);
+
+  value_type* const a = (value_type*)malloc(poly.size() * sizeof(value_type));
+  for (unsigned long k = 0; k < poly.size(); ++k) a[k] = rand_value();
+  poly._a = a;
+
+  value_type* x[multivariate_max_vars];
+  for (unsigned int v = 0; v < nvars; ++v)
+  {
+    x[v] = (value_type*)malloc(npoints * sizeof(value_type));
+    for (unsigned long p = 0; p < npoints; ++p) x[v][p] = rand_value();
+  }
+
+  value_type* const res = (value_type*)malloc(npoints * sizeof(value_type));
+  value_type* const ref = (value_type*)malloc(npoints * sizeof(value_type));
+
+  multivariate_seq<field_type>(poly, x, npoints, ref);
+
+  const uint64_t start = kaapi_get_elapsedns();
+  for (unsigned int iter = 0; iter < 10; ++iter)
+    multivariate_par<field_type>(poly, x, npoints, res);
+  const uint64_t stop = kaapi_get_elapsedns();
+  par_time = (double)(stop - start) / (10 * 1E6);
+
+  unsigned long nerr = 0;
+  for (unsigned long p = 0; p < npoints; ++p)
+  {
+    const double d = (double)res[p] - (double)ref[p];
+    if (fabs(d) > 1E-9 * (1. + fabs((double)ref[p]))) ++nerr;
+  }
+
+  // naive expansion on a few points
+  for (unsigned long p = 0; p < npoints; p += npoints / 4)
+  {
+    const double d = (double)naive_eval<field_type>(poly, x, p) - (double)ref[p];
+    if (fabs(d) > 1E-9 * (1. + fabs((double)ref[p]))) ++nerr;
+  }
+
+  for (unsigned int v = 0; v < nvars; ++v) free(x[v]);
+  free(a);
+  free(res);
+  free(ref);
+
+  return nerr;
+}
+
+static double rand_double() { return (double)rand() / RAND_MAX - 0.5; }
+static unsigned long rand_modp() { return modp(rand()); }
+
+int main(int ac, char** av)
+{
+  static const unsigned long n3[] = { 31, 31, 31 };
+  static const unsigned long n4[] = { 15, 15, 15, 15 };
+  static const unsigned long npoints = 1024;
+
+  ka::linearWork::toRemove::initialize();
+
+  double t3, t4, tm;
+  unsigned long nerr = 0;
+  nerr += check<doubleField>(3, n3, npoints, rand_double, t3);
+  nerr += check<doubleField>(4, n4, npoints, rand_double, t4);
+  nerr += check<modpField>(3, n3, npoints, rand_modp, tm);
+
+  printf("%u %lf %lf %lf %lu\n", kaapi_getconcurrency(), t3, t4, tm, nerr);
+
+  ka::linearWork::toRemove::finalize();
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "recurrence.hh"
+
+
+// parallel clenshaw and iir filtering against sequential versions
+
+
+static double* make_rand_series(unsigned long n)
+{
+  double* const a = (double*)malloc((n + 1) * sizeof(double));
+  for (unsigned long i = 0; i <= n; ++i) a[i] = (rand() % 10) / 1000.;
+  return a;
+}
+
+static double rel_err(double a, double b)
+{
+  const double d = fabs(a - b);
+  return d == 0. ? 0. : d / fmax(fabs(a), fabs(b));
+}
+
+int main(int ac, char** av)
+{
+  static const unsigned long n = 1024 * 1024;
+  double* const a = make_rand_series(n);
+  static const double x = 0.3;
+
+  ka::linearWork::toRemove::initialize();
+
+  // clenshaw
+  const double cheb_seq = clenshaw_seq<chebyshevFamily>(x, a, n);
+  const double leg_seq = clenshaw_seq<legendreFamily>(x, a, n);
+
+  uint64_t start = kaapi_get_elapsedns();
+
+  volatile double cheb_par = 0.;
+  for (unsigned int iter = 0; iter < 100; ++iter)
+    cheb_par = clenshaw_par<chebyshevFamily>(x, a, n);
+
+  uint64_t stop = kaapi_get_elapsedns();
+  const double cheb_time = (double)(stop - start) / (100 * 1E6);
+
+  const double leg_par = clenshaw_par<legendreFamily>(x, a, n);
+
+  // second order iir filter, low pass biquad
+  static const double fa[] = { 1., -1.5610180758, 0.6413515381 };
+  static const double fb[] = { 0.0200833656, 0.0401667311, 0.0200833656 };
+  const iirFilter<2> filter(fa, fb, 3);
+
+  double* const y_seq = (double*)malloc(n * sizeof(double));
+  double* const y_par = (double*)malloc(n * sizeof(double));
+  iir_seq(filter, a, y_seq, n);
+
+  start = kaapi_get_elapsedns();
+
+  for (unsigned int iter = 0; iter < 100; ++iter)
+    iir_par(filter, a, y_par, n);
+
+  stop = kaapi_get_elapsedns();
+  const double iir_time = (double)(stop - start) / (100 * 1E6);
+
+  double iir_err = 0.;
+  for (unsigned long t = 0; t < n; ++t)
+    iir_err = fmax(iir_err, fabs(y_seq[t] - y_par[t]));
+
+  printf("%u %lf %lf %e %e %e\n", kaapi_getconcurrency(),
+	 cheb_time, iir_time, rel_err(cheb_seq, cheb_par),
+	 rel_err(leg_seq, leg_par), iir_err);
+
+  ka::linearWork::toRemove::finalize();
+
+  free(y_par);
+  free(y_seq);
+  free(a);
+
+  return 0;
+}
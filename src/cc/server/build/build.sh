@@ -0,0 +1,27 @@
+#!/usr/bin/env sh
+
+XKAAPI_DIR="$HOME/install/xkaapi_master"
+XKAAPI_CFLAGS="-I$XKAAPI_DIR/include"
+XKAAPI_LFLAGS="-L$XKAAPI_DIR/lib -lkaapi -lpthread"
+
+g++ \
+    -Wall -O3 -march=native \
+    $XKAAPI_CFLAGS \
+    -I../../src \
+    -o server \
+    ../src/server.cc \
+    $XKAAPI_LFLAGS
+
+# the client side does not need the runtime
+
+g++ \
+    -Wall -O3 -march=native \
+    -I../../src \
+    -o client \
+    ../src/client.cc
+
+g++ \
+    -Wall -O3 -march=native \
+    -I../../src \
+    -o load \
+    ../src/load.cc
@@ -0,0 +1,16 @@
+#!/usr/bin/env sh
+
+XKAAPI_DIR="$HOME/install/xkaapi_master"
+SOCKET=/tmp/horner.sock
+
+LD_LIBRARY_PATH=$XKAAPI_DIR/lib:$LD_LIBRARY_PATH \
+KAAPI_CPUSET=0:47 \
+./server $SOCKET &
+SERVER_PID=$!
+sleep 1
+
+for c in 1 2 4 8 16 32 64; do
+    ./load -c $c -n 4194304 -m 4 -d 100000 -s 5 $SOCKET ;
+done
+
+kill $SERVER_PID
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "evalProtocol.hh"
+#include "mappedFile.hh"
+
+
+// evaluation server client.
+//
+// usage:
+// client socket register modp|double file
+// client [-d deadline_us] socket eval id modp|double x...
+//
+// register prints the polynom id. eval prints one result per
+// point, then the server latency on stderr.
+
+
+static const char* status_names[] =
+{
+  "ok", "deadline", "unknown id", "bad type", "bad request"
+};
+
+static void print_status(const char* op, uint32_t status)
+{
+  // the status comes from the socket
+  if (status < sizeof(status_names) / sizeof(status_names[0]))
+    fprintf(stderr, "%s: %s\n", op, status_names[status]);
+  else
+    fprintf(stderr, "%s: status %u\n", op, status);
+}
+
+
+static int do_register(int fd, uint32_t type, const char* path)
+{
+  mappedFile file;
+  if (file.open(path) == -1)
+  {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return -1;
+  }
+
+  evalRequest req;
+  req._op = EVAL_OP_REGISTER;
+  req._type = type;
+  req._id = 0;
+  req._count = file.size() / sizeof(uint64_t);
+  req._deadline_us = 0;
+  req._tag = 0;
+
+  evalReply rep;
+  if (eval_send_request(fd, req, (const uint64_t*)file.data()) == -1 ||
+      fd_read(fd, &rep, sizeof(rep)) == -1)
+  {
+    fprintf(stderr, "register: %s\n", strerror(errno));
+    return -1;
+  }
+
+  if (rep._status != EVAL_STATUS_OK)
+  {
+    print_status("register", rep._status);
+    return -1;
+  }
+
+  printf("%lu\n", (unsigned long)rep._id);
+  return 0;
+}
+
+static int do_eval
+(int fd, uint32_t type, uint64_t id, uint64_t deadline_us,
+ char** xs, unsigned int nx)
+{
+  uint64_t* const x = (uint64_t*)malloc(nx * sizeof(uint64_t));
+  for (unsigned int i = 0; i < nx; ++i)
+  {
+    if (type == EVAL_TYPE_MODP)
+      x[i] = eval_to_word(strtoul(xs[i], NULL, 10));
+    else
+      x[i] = eval_to_word(strtod(xs[i], NULL));
+  }
+
+  evalRequest req;
+  req._op = EVAL_OP_EVAL;
+  req._type = type;
+  req._id = id;
+  req._count = nx;
+  req._deadline_us = deadline_us;
+  req._tag = 0;
+
+  evalReply rep;
+  uint64_t* res = NULL;
+  int err = -1;
+
+  if (eval_send_request(fd, req, x) == -1 ||
+      fd_read(fd, &rep, sizeof(rep)) == -1 ||
+      eval_recv_values(fd, rep._count, &res) == -1)
+  {
+    fprintf(stderr, "eval: %s\n", strerror(errno));
+    goto on_error;
+  }
+
+  if (rep._status != EVAL_STATUS_OK)
+  {
+    print_status("eval", rep._status);
+    goto on_error;
+  }
+
+  for (uint64_t i = 0; i < rep._count; ++i)
+  {
+    if (type == EVAL_TYPE_MODP) printf("%lu\n", (unsigned long)res[i]);
+    else printf("%.17g\n", eval_to_double(res[i]));
+  }
+
+  fprintf(stderr, "%lf\n", (double)rep._latency_ns / 1E6);
+  err = 0;
+
+ on_error:
+  free(x);
+  free(res);
+  return err;
+}
+
+int main(int ac, char** av)
+{
+  uint64_t deadline_us = 0;
+  uint32_t type;
+  int fd, err;
+
+  int opt;
+  while ((opt = getopt(ac, av, "d:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'd':
+      deadline_us = strtoull(optarg, NULL, 10);
+      break ;
+
+    default:
+      goto on_usage;
+    }
+  }
+
+  if (ac - optind < 4) goto on_usage;
+  // register type file, eval id type x...
+  if (eval_parse_type
+      (av[optind + (strcmp(av[optind + 1], "eval") ? 2 : 3)], type) == -1)
+    goto on_usage;
+
+  fd = eval_connect(av[optind]);
+  if (fd == -1)
+  {
+    fprintf(stderr, "%s: %s\n", av[optind], strerror(errno));
+    return -1;
+  }
+
+  if (strcmp(av[optind + 1], "register") == 0 && ac - optind == 4)
+  {
+    err = do_register(fd, type, av[optind + 3]);
+  }
+  else if (strcmp(av[optind + 1], "eval") == 0 && ac - optind >= 5)
+  {
+    err = do_eval
+      (fd, type, strtoull(av[optind + 2], NULL, 10), deadline_us,
+       av + optind + 4, (unsigned int)(ac - optind - 4));
+  }
+  else
+  {
+    close(fd);
+    goto on_usage;
+  }
+
+  close(fd);
+  return err;
+
+ on_usage:
+  fprintf(stderr, "usage: %s socket register modp|double file\n", av[0]);
+  fprintf(stderr, "       %s [-d deadline_us] socket eval id modp|double x...\n", av[0]);
+  return -1;
+}
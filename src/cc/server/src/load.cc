@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include "evalProtocol.hh"
+#include "modp.hh"
+
+
+// evaluation server load generator. a random polynom is
+// registered, then each connection keeps one request in flight
+// for the given duration (closed loop).
+//
+// usage: load [-c nconns] [-n degree] [-t modp|double] [-m points]
+//             [-d deadline_us] [-s seconds] socket
+//
+// output: nconns requests/s points/s, then the client side
+// latency mean p50 p99 and the server side mean, in ms, then
+// the deadline misses.
+
+
+static const unsigned int max_conns = 256;
+
+
+static uint64_t elapsedns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t rand_word(uint32_t type)
+{
+  if (type == EVAL_TYPE_MODP) return eval_to_word((unsigned long)(rand() % modp_p));
+  return eval_to_word((double)rand() / (double)RAND_MAX);
+}
+
+static int register_rand_polynom
+(int fd, uint32_t type, unsigned long n, uint64_t& id)
+{
+  uint64_t* const a = (uint64_t*)malloc((n + 1) * sizeof(uint64_t));
+  for (unsigned long i = 0; i <= n; ++i) a[i] = rand_word(type);
+
+  evalRequest req;
+  req._op = EVAL_OP_REGISTER;
+  req._type = type;
+  req._id = 0;
+  req._count = n + 1;
+  req._deadline_us = 0;
+  req._tag = 0;
+
+  evalReply rep;
+  const int err = eval_send_request(fd, req, a) == -1 ||
+    fd_read(fd, &rep, sizeof(rep)) == -1 ||
+    rep._status != EVAL_STATUS_OK ? -1 : 0;
+
+  free(a);
+
+  id = rep._id;
+  return err;
+}
+
+int main(int ac, char** av)
+{
+  unsigned int nconns = 8;
+  unsigned long n = 1024 * 1024;
+  uint32_t type = EVAL_TYPE_MODP;
+  unsigned int m = 4;
+  uint64_t deadline_us = 0;
+  unsigned int secs = 5;
+
+  int opt;
+  while ((opt = getopt(ac, av, "c:n:t:m:d:s:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'c':
+      nconns = (unsigned int)atoi(optarg);
+      if (nconns == 0 || nconns > max_conns) goto on_usage;
+      break ;
+
+    case 'n':
+      n = strtoul(optarg, NULL, 10);
+      break ;
+
+    case 't':
+      if (eval_parse_type(optarg, type) == -1) goto on_usage;
+      break ;
+
+    case 'm':
+      m = (unsigned int)atoi(optarg);
+      if (m == 0) goto on_usage;
+      break ;
+
+    case 'd':
+      deadline_us = strtoull(optarg, NULL, 10);
+      break ;
+
+    case 's':
+      secs = (unsigned int)atoi(optarg);
+      break ;
+
+    default:
+      goto on_usage;
+    }
+  }
+
+  if (optind + 1 != ac) goto on_usage;
+
+  {
+    const char* const path = av[optind];
+
+    struct pollfd fds[max_conns];
+    uint64_t sent[max_conns];
+
+    for (unsigned int k = 0; k < nconns; ++k)
+    {
+      fds[k].fd = eval_connect(path);
+      fds[k].events = POLLIN;
+      if (fds[k].fd == -1)
+      {
+	fprintf(stderr, "%s: %s\n", path, strerror(errno));
+	return -1;
+      }
+    }
+
+    uint64_t id;
+    if (register_rand_polynom(fds[0].fd, type, n, id) == -1)
+    {
+      fprintf(stderr, "register: failed\n");
+      return -1;
+    }
+
+    uint64_t* const x = (uint64_t*)malloc(m * sizeof(uint64_t));
+    uint64_t* res = NULL;
+
+    evalRequest req;
+    req._op = EVAL_OP_EVAL;
+    req._type = type;
+    req._id = id;
+    req._count = m;
+    req._deadline_us = deadline_us;
+
+    // per request latencies
+    unsigned long nlats = 0, max_lats = 1024;
+    uint64_t* lats = (uint64_t*)malloc(max_lats * sizeof(uint64_t));
+    uint64_t server_ns = 0;
+    unsigned long npoints = 0, nmisses = 0;
+
+    const uint64_t start = elapsedns();
+    const uint64_t stop = start + (uint64_t)secs * 1000000000ULL;
+
+    for (unsigned int k = 0; k < nconns; ++k)
+    {
+      for (unsigned int i = 0; i < m; ++i) x[i] = rand_word(type);
+      req._tag = k;
+      sent[k] = elapsedns();
+      if (eval_send_request(fds[k].fd, req, x) == -1) goto on_error;
+    }
+
+    for (unsigned int ninflight = nconns; ninflight; )
+    {
+      if (poll(fds, nconns, -1) == -1)
+      {
+	if (errno == EINTR) continue ;
+	goto on_error;
+      }
+
+      for (unsigned int k = 0; k < nconns; ++k)
+      {
+	if ((fds[k].revents & POLLIN) == 0) continue ;
+
+	evalReply rep;
+	if (fd_read(fds[k].fd, &rep, sizeof(rep)) == -1 ||
+	    eval_recv_values(fds[k].fd, rep._count, &res) == -1)
+	  goto on_error;
+	free(res);
+	res = NULL;
+
+	const uint64_t now = elapsedns();
+
+	if (nlats == max_lats)
+	{
+	  max_lats *= 2;
+	  lats = (uint64_t*)realloc(lats, max_lats * sizeof(uint64_t));
+	}
+	lats[nlats++] = now - sent[k];
+	server_ns += rep._latency_ns;
+
+	if (rep._status == EVAL_STATUS_OK) npoints += m;
+	else if (rep._status == EVAL_STATUS_DEADLINE) ++nmisses;
+
+	// stop sending once the duration elapsed
+	if (now >= stop)
+	{
+	  fds[k].events = 0;
+	  --ninflight;
+	  continue ;
+	}
+
+	for (unsigned int i = 0; i < m; ++i) x[i] = rand_word(type);
+	req._tag = k;
+	sent[k] = now;
+	if (eval_send_request(fds[k].fd, req, x) == -1) goto on_error;
+      }
+    }
+
+    {
+      const double total = (double)(elapsedns() - start) / 1E9;
+
+      std::sort(lats, lats + nlats);
+      uint64_t sum = 0;
+      for (unsigned long i = 0; i < nlats; ++i) sum += lats[i];
+
+      printf("%u %lf %lf\n", nconns, (double)nlats / total,
+	     (double)npoints / total);
+      printf("%lf %lf %lf %lf\n",
+	     (double)sum / (1E6 * nlats),
+	     (double)lats[nlats / 2] / 1E6,
+	     (double)lats[(nlats * 99) / 100] / 1E6,
+	     (double)server_ns / (1E6 * nlats));
+      printf("%lu\n", nmisses);
+    }
+
+    for (unsigned int k = 0; k < nconns; ++k) close(fds[k].fd);
+    free(lats);
+    free(x);
+    return 0;
+
+  on_error:
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return -1;
+  }
+
+ on_usage:
+  fprintf(stderr, "usage: %s [-c nconns] [-n degree] [-t modp|double] [-m points]\n", av[0]);
+  fprintf(stderr, "       [-d deadline_us] [-s seconds] socket\n");
+  return -1;
+}
@@ -0,0 +1,514 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include "evalProtocol.hh"
+#include "mappedFile.hh"
+#include "multipoint.hh"
+
+
+// polynom evaluation server, see evalProtocol.hh.
+//
+// usage: server [-v] [-w window_us] [-f modp|double:file]... socket
+// -f: register the polynom of a file of n + 1 8 bytes values,
+// mapped. ids are given in the order of the options.
+// -w: batching window. a request waits at most that long, or
+// less if its deadline comes first, for others on the same
+// polynom to be evaluated in the same pass. default 100us.
+// -v: print each batch on stderr
+//
+// the server is a single thread event loop, the evaluations
+// themselves run in parallel. requests on the same polynom are
+// coalesced into one multi point evaluation. polynoms are served
+// by earliest deadline first. requests are read without blocking,
+// a partial request is kept in its connection until the rest
+// arrives. replies are written blocking, a client that does not
+// read its replies stalls the loop once the socket buffer is full.
+
+
+static const unsigned int max_polynoms = 1024;
+static const unsigned int max_conns = 256;
+
+
+struct polynom
+{
+  uint32_t _type;
+  unsigned long _n;
+
+  // n + 1 coefficients, as words
+  const uint64_t* _a;
+
+  // the coefficients are owned, not mapped
+  bool _is_owner;
+};
+
+// the request being read on a connection
+struct connection
+{
+  evalRequest _req;
+
+  // header bytes read
+  size_t _hpos;
+
+  // values, allocated once the header is read
+  uint64_t* _values;
+  size_t _vpos;
+
+  uint64_t _arrival;
+};
+
+struct pendingRequest
+{
+  int _fd;
+  evalRequest _req;
+  uint64_t* _x;
+  uint64_t _arrival;
+
+  // absolute, ~0 if none
+  uint64_t _deadline;
+};
+
+
+static polynom polynoms[max_polynoms];
+static mappedFile files[max_polynoms];
+static unsigned int npolynoms = 0;
+
+static pendingRequest* pendings = NULL;
+static unsigned int npendings = 0;
+static unsigned int max_pendings = 0;
+
+static bool is_verbose = false;
+
+
+static int register_file(const char* arg)
+{
+  const char* const colon = strchr(arg, ':');
+  if (colon == NULL || npolynoms == max_polynoms) return -1;
+
+  char type_name[16];
+  const size_t len = (size_t)(colon - arg);
+  if (len >= sizeof(type_name)) return -1;
+  memcpy(type_name, arg, len);
+  type_name[len] = 0;
+
+  polynom& p = polynoms[npolynoms];
+  if (eval_parse_type(type_name, p._type) == -1) return -1;
+
+  mappedFile& file = files[npolynoms];
+  if (file.open(colon + 1) == -1)
+  {
+    fprintf(stderr, "%s: %s\n", colon + 1, strerror(errno));
+    return -1;
+  }
+
+  if (file.size() < sizeof(uint64_t)) return -1;
+
+  p._n = file.size() / sizeof(uint64_t) - 1;
+  p._a = (const uint64_t*)file.data();
+  p._is_owner = false;
+
+  // the file is mapped read only, reduce a copy
+  if (p._type == EVAL_TYPE_MODP)
+  {
+    unsigned long i = 0;
+    while (i <= p._n && modp(p._a[i]) == p._a[i]) ++i;
+
+    if (i <= p._n)
+    {
+      uint64_t* const a = (uint64_t*)malloc((p._n + 1) * sizeof(uint64_t));
+      for (i = 0; i <= p._n; ++i) a[i] = modp(p._a[i]);
+      p._a = a;
+      p._is_owner = true;
+    }
+  }
+
+  ++npolynoms;
+  return 0;
+}
+
+static int reply_status
+(int fd, const evalRequest& req, uint32_t status, uint64_t arrival)
+{
+  evalReply rep;
+  rep._status = status;
+  rep._type = req._type;
+  rep._id = req._id;
+  rep._count = 0;
+  rep._latency_ns = kaapi_get_elapsedns() - arrival;
+  rep._tag = req._tag;
+  return eval_send_reply(fd, rep, NULL);
+}
+
+
+// handle a whole request read on fd. -1 if the connection is
+// to be closed.
+
+static int handle_request
+(int fd, evalRequest& req, uint64_t* values, uint64_t arrival)
+{
+  // values out of the field would overflow the modp products
+  if (req._type == EVAL_TYPE_MODP)
+    for (uint64_t i = 0; i < req._count; ++i) values[i] = modp(values[i]);
+
+  if (req._op == EVAL_OP_REGISTER)
+  {
+    if (req._count == 0 || npolynoms == max_polynoms ||
+	(req._type != EVAL_TYPE_MODP && req._type != EVAL_TYPE_DOUBLE))
+    {
+      free(values);
+      return reply_status(fd, req, EVAL_STATUS_BAD_REQUEST, arrival);
+    }
+
+    polynom& p = polynoms[npolynoms];
+    p._type = req._type;
+    p._n = req._count - 1;
+    p._a = values;
+    p._is_owner = true;
+
+    req._id = npolynoms++;
+    return reply_status(fd, req, EVAL_STATUS_OK, arrival);
+  }
+
+  uint32_t status = EVAL_STATUS_OK;
+  if (req._op != EVAL_OP_EVAL) status = EVAL_STATUS_BAD_REQUEST;
+  else if (req._id >= npolynoms) status = EVAL_STATUS_UNKNOWN_ID;
+  else if (req._type != polynoms[req._id]._type) status = EVAL_STATUS_BAD_TYPE;
+
+  if (status != EVAL_STATUS_OK || req._count == 0)
+  {
+    free(values);
+    return reply_status(fd, req, status, arrival);
+  }
+
+  if (npendings == max_pendings)
+  {
+    max_pendings = max_pendings ? 2 * max_pendings : 64;
+    pendings = (pendingRequest*)realloc
+      (pendings, max_pendings * sizeof(pendingRequest));
+  }
+
+  pendingRequest& pr = pendings[npendings++];
+  pr._fd = fd;
+  pr._req = req;
+  pr._x = values;
+  pr._arrival = arrival;
+  pr._deadline = req._deadline_us ?
+    arrival + req._deadline_us * 1000 : ~(uint64_t)0;
+
+  return 0;
+}
+
+
+// read what is available on fd without blocking, at most size
+// bytes. 0 if nothing is, -1 on error or if the peer closed.
+
+static ssize_t conn_read(int fd, void* buf, size_t size)
+{
+  while (1)
+  {
+    const ssize_t n = recv(fd, buf, size, MSG_DONTWAIT);
+    if (n > 0) return n;
+    if (n == 0) return -1;
+    if (errno == EINTR) continue ;
+    if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+    return -1;
+  }
+}
+
+// read the requests of a readable connection, handling the
+// whole ones. -1 if the connection is to be closed.
+
+static int handle_readable(int fd, connection& c)
+{
+  while (1)
+  {
+    if (c._hpos < sizeof(c._req))
+    {
+      const ssize_t n = conn_read
+	(fd, (char*)&c._req + c._hpos, sizeof(c._req) - c._hpos);
+      if (n <= 0) return (int)n;
+      c._hpos += (size_t)n;
+      if (c._hpos < sizeof(c._req)) continue ;
+
+      if (c._req._count > eval_max_count) return -1;
+
+      c._arrival = kaapi_get_elapsedns();
+      c._values = c._req._count ?
+	(uint64_t*)malloc(c._req._count * sizeof(uint64_t)) : NULL;
+      c._vpos = 0;
+    }
+
+    const size_t vsize = c._req._count * sizeof(uint64_t);
+    if (c._vpos < vsize)
+    {
+      const ssize_t n = conn_read
+	(fd, (char*)c._values + c._vpos, vsize - c._vpos);
+      if (n <= 0) return (int)n;
+      c._vpos += (size_t)n;
+      if (c._vpos < vsize) continue ;
+    }
+
+    // the values are handed over
+    uint64_t* const values = c._values;
+    c._values = NULL;
+    c._hpos = 0;
+
+    if (handle_request(fd, c._req, values, c._arrival) == -1) return -1;
+  }
+}
+
+
+// evaluate the requests of a polynom in one pass
+
+template<typename field_type>
+static void evaluate
+(const polynom& p, pendingRequest* const* reqs, unsigned int nreqs)
+{
+  typedef typename field_type::value_type value_type;
+
+  uint64_t m = 0;
+  for (unsigned int i = 0; i < nreqs; ++i) m += reqs[i]->_req._count;
+
+  value_type* const x = (value_type*)malloc(m * sizeof(value_type));
+  value_type* const res = (value_type*)malloc(m * sizeof(value_type));
+
+  uint64_t pos = 0;
+  for (unsigned int i = 0; i < nreqs; ++i)
+  {
+    memcpy(x + pos, reqs[i]->_x, reqs[i]->_req._count * sizeof(uint64_t));
+    pos += reqs[i]->_req._count;
+  }
+
+  multipoint_par<field_type>(x, m, (const value_type*)p._a, p._n, res);
+
+  const uint64_t now = kaapi_get_elapsedns();
+
+  pos = 0;
+  for (unsigned int i = 0; i < nreqs; ++i)
+  {
+    const pendingRequest& pr = *reqs[i];
+
+    // results overwrite the points, same size
+    memcpy(pr._x, res + pos, pr._req._count * sizeof(uint64_t));
+    pos += pr._req._count;
+
+    if (pr._fd == -1) continue ;
+
+    evalReply rep;
+    rep._status = EVAL_STATUS_OK;
+    rep._type = pr._req._type;
+    rep._id = pr._req._id;
+    rep._count = pr._req._count;
+    rep._latency_ns = now - pr._arrival;
+    rep._tag = pr._req._tag;
+    eval_send_reply(pr._fd, rep, pr._x);
+  }
+
+  free(x);
+  free(res);
+}
+
+
+// serve all the pending requests, polynom by polynom in
+// earliest deadline order
+
+static void serve_pendings()
+{
+  pendingRequest** const group = (pendingRequest**)
+    malloc(npendings * sizeof(pendingRequest*));
+
+  while (npendings)
+  {
+    unsigned int first = 0;
+    for (unsigned int i = 1; i < npendings; ++i)
+      if (pendings[i]._deadline < pendings[first]._deadline) first = i;
+
+    const uint64_t id = pendings[first]._req._id;
+    const uint64_t start = kaapi_get_elapsedns();
+
+    // expired requests are dropped from the group
+    unsigned int ngroup = 0;
+    uint64_t npoints = 0;
+    for (unsigned int i = 0; i < npendings; ++i)
+    {
+      pendingRequest& pr = pendings[i];
+      if (pr._req._id != id) continue ;
+
+      if (pr._deadline < start)
+      {
+	if (pr._fd != -1)
+	  reply_status(pr._fd, pr._req, EVAL_STATUS_DEADLINE, pr._arrival);
+	continue ;
+      }
+
+      group[ngroup++] = &pr;
+      npoints += pr._req._count;
+    }
+
+    const polynom& p = polynoms[id];
+    if (ngroup)
+    {
+      if (p._type == EVAL_TYPE_MODP) evaluate<modpField>(p, group, ngroup);
+      else evaluate<doubleField>(p, group, ngroup);
+    }
+
+    if (is_verbose)
+      fprintf(stderr, "batch %lu %u %lu %lf\n", (unsigned long)id, ngroup,
+	      (unsigned long)npoints,
+	      (double)(kaapi_get_elapsedns() - start) / 1E6);
+
+    // compact the remaining requests
+    unsigned int j = 0;
+    for (unsigned int i = 0; i < npendings; ++i)
+    {
+      if (pendings[i]._req._id == id) free(pendings[i]._x);
+      else pendings[j++] = pendings[i];
+    }
+    npendings = j;
+  }
+
+  free(group);
+}
+
+
+// time at which the pending requests must be served
+
+static uint64_t pendings_due(uint64_t window_ns)
+{
+  uint64_t due = ~(uint64_t)0;
+  for (unsigned int i = 0; i < npendings; ++i)
+  {
+    if (pendings[i]._arrival + window_ns < due)
+      due = pendings[i]._arrival + window_ns;
+    if (pendings[i]._deadline < due)
+      due = pendings[i]._deadline;
+  }
+  return due;
+}
+
+static void close_conn
+(struct pollfd* fds, connection* conns, unsigned int& nfds, unsigned int k)
+{
+  // pending requests are still evaluated, not replied
+  for (unsigned int i = 0; i < npendings; ++i)
+    if (pendings[i]._fd == fds[k].fd) pendings[i]._fd = -1;
+
+  close(fds[k].fd);
+  free(conns[k]._values);
+
+  --nfds;
+  fds[k] = fds[nfds];
+  conns[k] = conns[nfds];
+}
+
+int main(int ac, char** av)
+{
+  uint64_t window_ns = 100 * 1000;
+
+  int opt;
+  while ((opt = getopt(ac, av, "vw:f:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'v':
+      is_verbose = true;
+      break ;
+
+    case 'w':
+      window_ns = strtoull(optarg, NULL, 10) * 1000;
+      break ;
+
+    case 'f':
+      if (register_file(optarg) == -1) goto on_usage;
+      break ;
+
+    default:
+      goto on_usage;
+    }
+  }
+
+  if (optind + 1 != ac) goto on_usage;
+
+  {
+    const char* const path = av[optind];
+
+    // replies to closed connections
+    signal(SIGPIPE, SIG_IGN);
+
+    const int listen_fd = eval_listen(path);
+    if (listen_fd == -1)
+    {
+      fprintf(stderr, "%s: %s\n", path, strerror(errno));
+      return -1;
+    }
+
+    ka::linearWork::toRemove::initialize();
+
+    // fds[0] is the listening socket. conns[k] reads fds[k]
+    struct pollfd fds[max_conns + 1];
+    connection conns[max_conns + 1];
+    unsigned int nfds = 1;
+    fds[0].fd = listen_fd;
+    fds[0].events = POLLIN;
+
+    while (1)
+    {
+      // wait at most until the pending requests are due
+      struct timespec ts;
+      struct timespec* timeout = NULL;
+      if (npendings)
+      {
+	const uint64_t due = pendings_due(window_ns);
+	const uint64_t now = kaapi_get_elapsedns();
+	const uint64_t ns = due > now ? due - now : 0;
+	ts.tv_sec = (time_t)(ns / 1000000000);
+	ts.tv_nsec = (long)(ns % 1000000000);
+	timeout = &ts;
+      }
+
+      if (ppoll(fds, nfds, timeout, NULL) == -1 && errno != EINTR) break ;
+
+      for (unsigned int k = nfds - 1; k > 0; --k)
+      {
+	if (fds[k].revents == 0) continue ;
+	if ((fds[k].revents & POLLIN) == 0 ||
+	    handle_readable(fds[k].fd, conns[k]) == -1)
+	  close_conn(fds, conns, nfds, k);
+      }
+
+      if (fds[0].revents & POLLIN)
+      {
+	const int fd = accept(listen_fd, NULL, NULL);
+	if (fd != -1)
+	{
+	  if (nfds == max_conns + 1) close(fd);
+	  else
+	  {
+	    fds[nfds].fd = fd;
+	    fds[nfds].events = POLLIN;
+	    fds[nfds].revents = 0;
+	    conns[nfds]._hpos = 0;
+	    conns[nfds]._values = NULL;
+	    ++nfds;
+	  }
+	}
+      }
+
+      if (npendings && kaapi_get_elapsedns() >= pendings_due(window_ns))
+	serve_pendings();
+    }
+
+    ka::linearWork::toRemove::finalize();
+  }
+
+  return 0;
+
+ on_usage:
+  fprintf(stderr, "usage: %s [-v] [-w window_us] [-f modp|double:file]... socket\n", av[0]);
+  return -1;
+}
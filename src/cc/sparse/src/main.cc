@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "sparse.hh"
+
+
+// sparse polynoms of degree about 10^9 with 10^5 terms
+
+
+template<typename coef_type>
+static sparseTerm<coef_type>* make_rand_sparse
+(unsigned long nterms, unsigned long max_gap, coef_type (*rand_coef)())
+{
+  sparseTerm<coef_type>* const terms = (sparseTerm<coef_type>*)malloc
+    (nterms * sizeof(sparseTerm<coef_type>));
+
+  // built from the lowest exponent
+  unsigned long e = (unsigned long)rand() % max_gap;
+  for (unsigned long k = nterms; k; --k)
+  {
+    terms[k - 1]._e = e;
+    terms[k - 1]._c = rand_coef();
+    e += 1 + (unsigned long)rand() % max_gap;
+  }
+
+  return terms;
+}
+
+static unsigned long rand_modp() { return modp(rand()); }
+static double rand_double() { return (double)rand() / RAND_MAX; }
+
+int main(int ac, char** av)
+{
+  static const unsigned long nterms = 100 * 1000;
+  static const unsigned long max_gap = 20 * 1000;
+
+  sparseTerm<unsigned long>* const a =
+    make_rand_sparse<unsigned long>(nterms, max_gap, rand_modp);
+  sparseTerm<double>* const da =
+    make_rand_sparse<double>(nterms, max_gap, rand_double);
+
+  static const unsigned long x = 2;
+  static const double dx = 1. - 1E-9;
+
+  ka::linearWork::toRemove::initialize();
+
+  unsigned long nerr = 0;
+
+  // reference, term by term
+  unsigned long ref = 0;
+  double dref = 0.;
+  for (unsigned long k = 0; k < nterms; ++k)
+  {
+    ref = add_modp(ref, mul_modp(a[k]._c, pow_modp(x, a[k]._e)));
+    dref += da[k]._c * pow(dx, (double)da[k]._e);
+  }
+
+  if (sparse_horner_seq<modpField>(x, a, nterms) != ref) ++nerr;
+
+  uint64_t start = kaapi_get_elapsedns();
+
+  unsigned long res = 0;
+  for (unsigned int iter = 0; iter < 100; ++iter)
+    res = sparse_horner_par<modpField>(x, a, nterms);
+
+  uint64_t stop = kaapi_get_elapsedns();
+  const double par_time = (double)(stop - start) / (100 * 1E6);
+
+  if (res != ref) ++nerr;
+
+  const double dres = sparse_horner_par<doubleField>(dx, da, nterms);
+  if (fabs(dres - dref) > 1E-9 * fabs(dref)) ++nerr;
+
+  printf("%u %lu %lf %lu == %lu %lu\n", kaapi_getconcurrency(),
+	 a[0]._e, par_time, res, ref, nerr);
+
+  ka::linearWork::toRemove::finalize();
+
+  free(a);
+  free(da);
+
+  return 0;
+}
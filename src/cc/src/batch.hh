@@ -0,0 +1,196 @@
+#ifndef BATCH_HH_INCLUDED
+# define BATCH_HH_INCLUDED
+
+
+// evaluation of np polynoms of degree n at m points, ie. the
+// product of the vandermonde matrix of the points by the matrix
+// of the coefficients. the polynom j is a[j * (n + 1) ..], highest
+// degree first, and res[j * m + k] = p_j(x[k]).
+//
+// the work range is the set of outer tiles of the result, a block
+// of polynoms by a block of points sized for the l1 cache. inside
+// a tile, horner runs on register tiles of batch_poly_regs polynoms
+// by batch_point_regs points: each coefficient loaded is used for
+// all the points of the tile, each point for all the polynoms, and
+// the point loop vectorizes.
+
+
+#include "kaLinearWork.hh"
+#include "horner.hh"
+
+
+// register tile
+static const unsigned int batch_poly_regs = 4;
+static const unsigned int batch_point_regs = 8;
+
+// outer tile
+static const unsigned long batch_poly_block = 16;
+static const unsigned long batch_point_block = 256;
+
+
+// register tile, full or partial. np <= batch_poly_regs and
+// nx <= batch_point_regs. a full tile has constant bounds.
+
+template<typename field_type, typename coef_type>
+static inline void batch_tile
+(
+ const coef_type* a, unsigned long n, unsigned long np,
+ const typename field_type::value_type* x, unsigned long nx,
+ typename field_type::value_type* res, unsigned long m
+)
+{
+  typedef typename field_type::value_type value_type;
+
+  static const unsigned int pr = batch_poly_regs;
+  static const unsigned int xr = batch_point_regs;
+
+  value_type acc[pr][xr];
+  value_type c[pr];
+
+  for (unsigned int j = 0; j < np; ++j)
+    for (unsigned int q = 0; q < nx; ++q)
+      acc[j][q] = a[j * (n + 1)];
+
+  for (unsigned long i = 1; i <= n; ++i)
+  {
+    for (unsigned int j = 0; j < np; ++j) c[j] = a[j * (n + 1) + i];
+
+    for (unsigned int j = 0; j < np; ++j)
+      for (unsigned int q = 0; q < nx; ++q)
+	acc[j][q] = field_type::axb(acc[j][q], x[q], c[j]);
+  }
+
+  for (unsigned int j = 0; j < np; ++j)
+    for (unsigned int q = 0; q < nx; ++q)
+      res[j * m + q] = acc[j][q];
+}
+
+template<typename field_type, typename coef_type>
+static void batch_block
+(
+ const coef_type* a, unsigned long n, unsigned long np,
+ const typename field_type::value_type* x, unsigned long nx,
+ typename field_type::value_type* res, unsigned long m
+)
+{
+  static const unsigned int pr = batch_poly_regs;
+  static const unsigned int xr = batch_point_regs;
+
+  for (unsigned long j = 0; j < np; j += pr)
+  {
+    const coef_type* const aj = a + j * (n + 1);
+    const unsigned long pj = np - j < pr ? np - j : pr;
+
+    for (unsigned long k = 0; k < nx; k += xr)
+    {
+      if (pj == pr && nx - k >= xr)
+	batch_tile<field_type, coef_type>
+	  (aj, n, pr, x + k, xr, res + j * m + k, m);
+      else
+	batch_tile<field_type, coef_type>
+	  (aj, n, pj, x + k, nx - k < xr ? nx - k : xr, res + j * m + k, m);
+    }
+  }
+}
+
+
+template<typename field_type, typename coef_type>
+class batchWork : public ka::linearWork::baseWork
+{
+  // the work index t computes the outer tile t of res
+
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef ka::linearWork::voidResult result_type;
+  typedef typename field_type::value_type value_type;
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 1;
+  static const unsigned int par_grain = 1;
+
+  const coef_type* _a;
+  unsigned long _n;
+  unsigned long _np;
+  const value_type* _x;
+  unsigned long _m;
+  value_type* _out;
+
+  // point tiles per polynom tile row
+  unsigned long _nt;
+
+  batchWork
+  (const coef_type* a, unsigned long n, unsigned long np,
+   const value_type* x, unsigned long m, value_type* res,
+   unsigned long nt, unsigned long ntiles)
+    : baseWork(0, ntiles), _a(a), _n(n), _np(np),
+      _x(x), _m(m), _out(res), _nt(nt) {}
+
+  void initialize(const batchWork& w)
+  {
+    _a = w._a;
+    _n = w._n;
+    _np = w._np;
+    _x = w._x;
+    _m = w._m;
+    _out = w._out;
+    _nt = w._nt;
+  }
+
+  void execute(result_type&, const range_type& r)
+  {
+    for (range_type::index_type t = r.begin(); t < r.end(); ++t)
+    {
+      const unsigned long j0 = (t / _nt) * batch_poly_block;
+      const unsigned long k0 = (t % _nt) * batch_point_block;
+      const unsigned long j1 =
+	j0 + batch_poly_block < _np ? j0 + batch_poly_block : _np;
+      const unsigned long k1 =
+	k0 + batch_point_block < _m ? k0 + batch_point_block : _m;
+
+      batch_block<field_type, coef_type>
+	(_a + j0 * (_n + 1), _n, j1 - j0, _x + k0, k1 - k0,
+	 _out + j0 * _m + k0, _m);
+    }
+  }
+
+  void reduce(result_type&, const result_type&, const range_type&) {}
+
+};
+
+
+template<typename field_type, typename coef_type>
+static void batch_par
+(
+ const coef_type* a, unsigned long n, unsigned long np,
+ const typename field_type::value_type* x, unsigned long m,
+ typename field_type::value_type* res
+)
+{
+  if (np == 0 || m == 0) return ;
+
+  const unsigned long nt = (m + batch_point_block - 1) / batch_point_block;
+  const unsigned long ntiles =
+    nt * ((np + batch_poly_block - 1) / batch_poly_block);
+
+  batchWork<field_type, coef_type> work(a, n, np, x, m, res, nt, ntiles);
+  ka::linearWork::execute(work);
+}
+
+// a horner per pair
+
+template<typename field_type, typename coef_type>
+static void batch_seq
+(
+ const coef_type* a, unsigned long n, unsigned long np,
+ const typename field_type::value_type* x, unsigned long m,
+ typename field_type::value_type* res
+)
+{
+  for (unsigned long j = 0; j < np; ++j)
+    for (unsigned long k = 0; k < m; ++k)
+      res[j * m + k] = horner_seq<field_type>(x[k], a + j * (n + 1), n);
+}
+
+
+#endif // ! BATCH_HH_INCLUDED
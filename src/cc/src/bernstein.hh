@@ -0,0 +1,269 @@
+#ifndef BERNSTEIN_HH_INCLUDED
+# define BERNSTEIN_HH_INCLUDED
+
+
+// bernstein basis evaluation, for bezier curves and patches.
+// control points are stored as structures of arrays: ctrl[d][i]
+// is the coordinate d of the point i, i in [0, n]. parameters
+// are split among the workers, each range being evaluated by
+// blocks of block_size parameters.
+//
+// two kernels are provided:
+// . de casteljau, O(n^2), the reference for stability. the
+// innermost loop runs over the parameters of a block, in simd.
+// . a horner like scheme in O(n), using the symmetry t -> 1 - t
+// so that t <= 1/2. the scaled binomial C(n, i) * t^i stays
+// finite up to a degree around 1000.
+
+
+#include <stdlib.h>
+#include "kaLinearWork.hh"
+
+
+static const unsigned int bernstein_block_size = 8;
+
+
+static void de_casteljau_block
+(
+ const double* ctrl, unsigned long n,
+ const double* t, unsigned int count,
+ double* out, double* tmp
+)
+{
+  // tmp holds (n + 1) * block_size values
+
+  static const unsigned int w = bernstein_block_size;
+
+  double tt[w], ut[w];
+  for (unsigned int k = 0; k < w; ++k)
+  {
+    tt[k] = k < count ? t[k] : 0.;
+    ut[k] = 1. - tt[k];
+  }
+
+  for (unsigned long i = 0; i <= n; ++i)
+    for (unsigned int k = 0; k < w; ++k)
+      tmp[i * w + k] = ctrl[i];
+
+  for (unsigned long r = 1; r <= n; ++r)
+    for (unsigned long i = 0; i <= n - r; ++i)
+    {
+      double* const lo = tmp + i * w;
+      const double* const hi = lo + w;
+      for (unsigned int k = 0; k < w; ++k)
+	lo[k] = ut[k] * lo[k] + tt[k] * hi[k];
+    }
+
+  for (unsigned int k = 0; k < count; ++k) out[k] = tmp[k];
+}
+
+static double bernstein_horner
+(const double* ctrl, unsigned long n, double t)
+{
+  if (n == 0) return ctrl[0];
+
+  // reversed control points when t > 1/2
+  long i0 = 0, di = 1;
+  if (t > 0.5)
+  {
+    t = 1. - t;
+    i0 = (long)n;
+    di = -1;
+  }
+
+  const double u = 1. - t;
+
+  // scaled = C(n, i) * t^i
+  double scaled = 1.;
+  double res = ctrl[i0] * u;
+
+  for (unsigned long i = 1; i < n; ++i)
+  {
+    scaled *= t * (double)(n - i + 1) / (double)i;
+    res = (res + scaled * ctrl[i0 + di * (long)i]) * u;
+  }
+
+  // C(n, n) * t^n
+  scaled *= t / (double)n;
+  return res + scaled * ctrl[i0 + di * (long)n];
+}
+
+
+// curve work. kernel selection by the use_casteljau flag
+
+class bezierCurveWork : public ka::linearWork::baseWork
+{
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef ka::linearWork::voidResult result_type;
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 256;
+  static const unsigned int par_grain = 256;
+
+  // control points, dimension and degree
+  const double* const* _ctrl;
+  unsigned int _dim;
+  unsigned long _n;
+
+  // parameters, outputs out[d][j]
+  const double* _t;
+  double* const* _out;
+
+  bool _use_casteljau;
+
+  // de casteljau scratch, (n + 1) * bernstein_block_size
+  double* _tmp;
+
+  bezierCurveWork
+  (const double* const* ctrl, unsigned int dim, unsigned long n,
+   const double* t, unsigned long nt, double* const* out,
+   bool use_casteljau)
+    : baseWork(0, nt), _ctrl(ctrl), _dim(dim), _n(n),
+      _t(t), _out(out), _use_casteljau(use_casteljau), _tmp(NULL) {}
+
+  void initialize(const bezierCurveWork& w)
+  {
+    _ctrl = w._ctrl;
+    _dim = w._dim;
+    _n = w._n;
+    _t = w._t;
+    _out = w._out;
+    _use_casteljau = w._use_casteljau;
+    _tmp = NULL;
+  }
+
+  void finalize()
+  {
+    free(_tmp);
+    _tmp = NULL;
+  }
+
+  void execute(result_type&, const range_type& r)
+  {
+    if (_use_casteljau == false)
+    {
+      for (unsigned int d = 0; d < _dim; ++d)
+	for (range_type::index_type j = r.begin(); j < r.end(); ++j)
+	  _out[d][j] = bernstein_horner(_ctrl[d], _n, _t[j]);
+      return ;
+    }
+
+    static const unsigned int w = bernstein_block_size;
+    if (_tmp == NULL)
+      _tmp = (double*)malloc((_n + 1) * w * sizeof(double));
+
+    for (range_type::index_type j = r.begin(); j < r.end(); j += w)
+    {
+      const unsigned int count =
+	r.end() - j < w ? (unsigned int)(r.end() - j) : w;
+      for (unsigned int d = 0; d < _dim; ++d)
+	de_casteljau_block
+	  (_ctrl[d], _n, _t + j, count, _out[d] + j, _tmp);
+    }
+  }
+
+  void reduce(result_type&, const result_type&, const range_type&) {}
+
+};
+
+static void bezier_curve_par
+(
+ const double* const* ctrl, unsigned int dim, unsigned long n,
+ const double* t, unsigned long nt, double* const* out,
+ bool use_casteljau = false
+)
+{
+  if (nt == 0) return ;
+  bezierCurveWork work(ctrl, dim, n, t, nt, out, use_casteljau);
+  ka::linearWork::execute(work);
+}
+
+
+// tensor product patch of degree (n, m). the control point
+// (i, k) of the dimension d is ctrl[d][i * (m + 1) + k]. the
+// rows are evaluated at v, then the resulting column at u.
+
+class bezierPatchWork : public ka::linearWork::baseWork
+{
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef ka::linearWork::voidResult result_type;
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 64;
+  static const unsigned int par_grain = 64;
+
+  const double* const* _ctrl;
+  unsigned int _dim;
+  unsigned long _n, _m;
+
+  const double* _u;
+  const double* _v;
+  double* const* _out;
+
+  // the column of row results, n + 1
+  double* _col;
+
+  bezierPatchWork
+  (const double* const* ctrl, unsigned int dim,
+   unsigned long n, unsigned long m,
+   const double* u, const double* v, unsigned long nuv,
+   double* const* out)
+    : baseWork(0, nuv), _ctrl(ctrl), _dim(dim), _n(n), _m(m),
+      _u(u), _v(v), _out(out), _col(NULL) {}
+
+  void initialize(const bezierPatchWork& w)
+  {
+    _ctrl = w._ctrl;
+    _dim = w._dim;
+    _n = w._n;
+    _m = w._m;
+    _u = w._u;
+    _v = w._v;
+    _out = w._out;
+    _col = NULL;
+  }
+
+  void finalize()
+  {
+    free(_col);
+    _col = NULL;
+  }
+
+  void execute(result_type&, const range_type& r)
+  {
+    // rows evaluated along v, then the column along u
+    if (_col == NULL) _col = (double*)malloc((_n + 1) * sizeof(double));
+    double* const col = _col;
+
+    for (unsigned int d = 0; d < _dim; ++d)
+      for (range_type::index_type j = r.begin(); j < r.end(); ++j)
+      {
+	for (unsigned long i = 0; i <= _n; ++i)
+	  col[i] = bernstein_horner(_ctrl[d] + i * (_m + 1), _m, _v[j]);
+	_out[d][j] = bernstein_horner(col, _n, _u[j]);
+      }
+  }
+
+  void reduce(result_type&, const result_type&, const range_type&) {}
+
+};
+
+static void bezier_patch_par
+(
+ const double* const* ctrl, unsigned int dim,
+ unsigned long n, unsigned long m,
+ const double* u, const double* v, unsigned long nuv,
+ double* const* out
+)
+{
+  if (nuv == 0) return ;
+  bezierPatchWork work(ctrl, dim, n, m, u, v, nuv, out);
+  ka::linearWork::execute(work);
+}
+
+
+#endif // ! BERNSTEIN_HH_INCLUDED
@@ -0,0 +1,190 @@
+#ifndef DEFLATE_HH_INCLUDED
+# define DEFLATE_HH_INCLUDED
+
+
+// synthetic division by (x - c). the horner intermediates are
+// the quotient coefficients, the final value is the remainder.
+// coefficients are stored highest degree first, a[0] being the
+// degree n coefficient. the quotient q has n coefficients.
+//
+// the work index i computes the intermediate for a[i + 1].
+// thieves start from zero, the reduction of a thief on the
+// range [i, j[ against a victim value v records (i, j, v) and
+// the element k of the range is later fixed up by v * c^(k-i+1).
+
+
+#include "kaLinearWork.hh"
+#include "kaScan.hh"
+#include "field.hh"
+
+
+template<typename field_type>
+class deflateWork;
+
+template<typename field_type>
+class deflateResult : public ka::linearWork::baseResult
+{
+public:
+  typedef typename field_type::value_type value_type;
+
+  value_type _res;
+
+  deflateResult(value_type res) : _res(res) {}
+
+  void initialize(const deflateWork<field_type>&)
+  { _res = field_type::zero(); }
+};
+
+
+template<typename field_type>
+class deflateWork : public ka::linearWork::baseWork
+{
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef typename field_type::value_type value_type;
+  typedef ka::scan::segmentTable<value_type> table_type;
+
+  static const bool is_reducable = true;
+  static const unsigned int seq_grain = 256;
+  static const unsigned int par_grain = 256;
+
+  value_type _c;
+  const value_type* _a;
+  value_type* _q;
+  unsigned long _n;
+  table_type* _table;
+
+  deflateWork
+  (value_type c, const value_type* a, value_type* q,
+   unsigned long n, table_type* table)
+    : baseWork(0, n), _c(c), _a(a), _q(q), _n(n), _table(table) {}
+
+  void initialize(const deflateWork& w)
+  {
+    _c = w._c;
+    _a = w._a;
+    _q = w._q;
+    _n = w._n;
+    _table = w._table;
+  }
+
+  void execute(deflateResult<field_type>& res, const range_type& r)
+  {
+    value_type local_res = res._res;
+
+    // the last index computes the remainder, not stored in q
+    const range_type::index_type end =
+      r.end() == _n ? r.end() - 1 : r.end();
+
+    range_type::index_type i = r.begin();
+    for (; i < end; ++i)
+    {
+      local_res = field_type::axb(local_res, _c, _a[i + 1]);
+      _q[i + 1] = local_res;
+    }
+
+    if (i != r.end())
+      local_res = field_type::axb(local_res, _c, _a[i + 1]);
+
+    res._res = local_res;
+  }
+
+  void reduce
+  (deflateResult<field_type>& lhs, const deflateResult<field_type>& rhs,
+   const range_type& processed)
+  {
+    _table->push(processed, lhs._res);
+
+    lhs._res = field_type::add
+      (field_type::mul(lhs._res, field_type::pow(_c, processed.size())),
+       rhs._res);
+  }
+
+};
+
+
+template<typename field_type>
+class deflateFixupOp
+{
+  // q[k + 1] += carry * c^(k - i + 1)
+
+public:
+  typedef typename field_type::value_type value_type;
+  typedef ka::scan::segmentTable<value_type> table_type;
+  typedef typename table_type::segment_type segment_type;
+
+  value_type _c;
+  value_type* _q;
+  unsigned long _n;
+
+  deflateFixupOp(value_type c, value_type* q, unsigned long n)
+    : _c(c), _q(q), _n(n) {}
+
+  void operator()
+  (const segment_type& s, unsigned long lo, unsigned long hi)
+  {
+    // the remainder is reduced by the master, not stored
+    if (hi == _n) --hi;
+
+    value_type p = field_type::mul
+      (s._carry, field_type::pow(_c, lo - s._i + 1));
+
+    for (unsigned long k = lo; k < hi; ++k)
+    {
+      _q[k + 1] = field_type::add(_q[k + 1], p);
+      p = field_type::mul(p, _c);
+    }
+  }
+};
+
+
+// divide a by (x - c). store the quotient in q, return the remainder.
+
+template<typename field_type>
+static typename field_type::value_type deflate_par
+(
+ typename field_type::value_type c,
+ const typename field_type::value_type* a,
+ unsigned long n,
+ typename field_type::value_type* q
+)
+{
+  if (n == 0) return a[0];
+
+  q[0] = a[0];
+
+  typename deflateWork<field_type>::table_type table(n);
+
+  deflateWork<field_type> work(c, a, q, n, &table);
+  deflateResult<field_type> res(a[0]);
+  ka::linearWork::execute(work, res);
+
+  deflateFixupOp<field_type> op(c, q, n);
+  ka::scan::fixup(table, op, n);
+
+  return res._res;
+}
+
+template<typename field_type>
+static typename field_type::value_type deflate_seq
+(
+ typename field_type::value_type c,
+ const typename field_type::value_type* a,
+ unsigned long n,
+ typename field_type::value_type* q
+)
+{
+  typename field_type::value_type res = a[0];
+
+  for (unsigned long i = 1; i <= n; ++i)
+  {
+    q[i - 1] = res;
+    res = field_type::axb(res, c, a[i]);
+  }
+
+  return res;
+}
+
+
+#endif // ! DEFLATE_HH_INCLUDED
@@ -0,0 +1,271 @@
+#ifndef DIST_HH_INCLUDED
+# define DIST_HH_INCLUDED
+
+
+// multi process horner evaluation modulo p. the coefficients
+// are shared with the workers either through a posix shared
+// memory object or through a file of n + 1 native unsigned
+// longs, highest degree first. the work range [0, n[ is cut in
+// one contiguous range per worker. each worker process runs its
+// own runtime on its range and sends (partial, range length)
+// back over a unix socket. the coordinator folds the partials
+// in range order with res = res * x^len + partial, which is the
+// reduction of hornerFieldWork.
+//
+// the coordinator does not initialize the runtime: the workers
+// are forked and a runtime with running threads does not
+// survive fork. each worker may be given its own KAAPI_CPUSET.
+// errors are reported as -1, errno being set when meaningful.
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "horner.hh"
+#include "mappedFile.hh"
+#include "fdio.hh"
+
+
+// sent by a worker once its range is evaluated
+
+struct distMessage
+{
+  uint64_t _i, _j;
+  uint64_t _res;
+
+  // worker side evaluation time
+  uint64_t _ns;
+};
+
+
+// coefficients in a posix shared memory object
+
+class sharedPolynom
+{
+public:
+  unsigned long* _a;
+  size_t _size;
+
+  sharedPolynom() : _a(NULL), _size(0) {}
+
+  ~sharedPolynom() { close(); }
+
+  // create a read write object of n + 1 coefficients
+  int create(const char* name, unsigned long n)
+  {
+    const int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1) return -1;
+
+    _size = (n + 1) * sizeof(unsigned long);
+    if (ftruncate(fd, (off_t)_size) == -1) goto on_error;
+
+    return map(fd, PROT_READ | PROT_WRITE);
+
+  on_error:
+    ::close(fd);
+    shm_unlink(name);
+    _size = 0;
+    return -1;
+  }
+
+  int open(const char* name)
+  {
+    const int fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+    {
+      ::close(fd);
+      return -1;
+    }
+
+    _size = (size_t)st.st_size;
+    return map(fd, PROT_READ);
+  }
+
+  void close()
+  {
+    if (_a != NULL) munmap((void*)_a, _size);
+    _a = NULL;
+    _size = 0;
+  }
+
+  static int unlink(const char* name)
+  { return shm_unlink(name); }
+
+private:
+
+  int map(int fd, int prot)
+  {
+    void* const p = mmap(NULL, _size, prot, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (p == MAP_FAILED)
+    {
+      _size = 0;
+      return -1;
+    }
+
+    _a = (unsigned long*)p;
+    return 0;
+  }
+};
+
+
+// where the workers find the coefficients
+
+struct distSource
+{
+  const char* _name;
+
+  // _name is a file, not a shared memory object
+  bool _is_file;
+};
+
+
+static inline uint64_t dist_elapsedns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+// worker process body. the range [i, j[ is evaluated with the
+// local engine, the worker owning i = 0 seeds with a[0].
+
+static inline int dist_worker
+(const distSource& src, unsigned long x, uint64_t i, uint64_t j, int fd)
+{
+  mappedFile file;
+  sharedPolynom shm;
+  const unsigned long* a;
+
+  if (src._is_file)
+  {
+    if (file.open(src._name) == -1) return -1;
+    a = (const unsigned long*)file.data();
+  }
+  else
+  {
+    if (shm.open(src._name) == -1) return -1;
+    a = shm._a;
+  }
+
+  ka::linearWork::toRemove::initialize();
+
+  distMessage msg;
+  msg._i = i;
+  msg._j = j;
+
+  const uint64_t start = dist_elapsedns();
+  msg._res = horner_par_range<modpField>
+    (x, a, i, j, i == 0 ? a[0] : modpField::zero());
+  msg._ns = dist_elapsedns() - start;
+
+  ka::linearWork::toRemove::finalize();
+
+  return fd_write(fd, &msg, sizeof(msg));
+}
+
+
+// evaluate the degree n polynom of src at x with nprocs worker
+// processes. cpusets, if not NULL, holds the KAAPI_CPUSET of each
+// worker. msgs, if not NULL, receives the nprocs worker replies.
+
+static inline int dist_horner
+(
+ const distSource& src, unsigned long x, unsigned long n,
+ unsigned int nprocs, const char* const* cpusets,
+ unsigned long& res, distMessage* msgs = NULL
+)
+{
+  pid_t* const pids = (pid_t*)malloc(nprocs * sizeof(pid_t));
+  int* const fds = (int*)malloc(nprocs * sizeof(int));
+  unsigned int nforked = 0;
+  int err = 0;
+
+  for (; nforked < nprocs; ++nforked)
+  {
+    const unsigned int k = nforked;
+    const uint64_t i = ((uint64_t)n * k) / nprocs;
+    const uint64_t j = ((uint64_t)n * (k + 1)) / nprocs;
+
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1)
+    {
+      err = -1;
+      break ;
+    }
+
+    const pid_t pid = fork();
+
+    if (pid == -1)
+    {
+      ::close(sv[0]);
+      ::close(sv[1]);
+      err = -1;
+      break ;
+    }
+
+    if (pid == 0)
+    {
+      // the coordinator ends of the previous workers are
+      // left open, they are closed on exit
+      ::close(sv[0]);
+      if (cpusets != NULL && cpusets[k] != NULL)
+	setenv("KAAPI_CPUSET", cpusets[k], 1);
+      _exit(dist_worker(src, x, i, j, sv[1]) == -1 ? 1 : 0);
+    }
+
+    ::close(sv[1]);
+    pids[k] = pid;
+    fds[k] = sv[0];
+  }
+
+  // fold in range order, replies are read in that order
+  res = modpField::zero();
+  for (unsigned int k = 0; k < nforked; ++k)
+  {
+    distMessage msg;
+
+    if (err == 0 && fd_read(fds[k], &msg, sizeof(msg)) == 0)
+    {
+      res = modpField::axb
+	(res, modpField::pow(x, msg._j - msg._i), msg._res);
+      if (msgs != NULL) msgs[k] = msg;
+    }
+    else
+    {
+      err = -1;
+    }
+
+    ::close(fds[k]);
+  }
+
+  for (unsigned int k = 0; k < nforked; ++k)
+  {
+    int status = 0;
+    pid_t pid;
+    while ((pid = waitpid(pids[k], &status, 0)) == -1 && errno == EINTR) ;
+    if (pid == -1 || !WIFEXITED(status) || WEXITSTATUS(status)) err = -1;
+  }
+
+  free(pids);
+  free(fds);
+
+  return err;
+}
+
+
+#endif // ! DIST_HH_INCLUDED
@@ -0,0 +1,202 @@
+#ifndef EVAL_PROTOCOL_HH_INCLUDED
+# define EVAL_PROTOCOL_HH_INCLUDED
+
+
+// evaluation server protocol, over a unix stream socket. all
+// the fields are native endian, the client and the server run
+// on the same host. a request is a header followed by _count 8
+// bytes values, a reply likewise. values are unsigned longs for
+// the modp type and doubles for the double type.
+//
+// EVAL_OP_REGISTER: the values are the n + 1 coefficients of a
+// polynom of the type _type, highest degree first. the reply _id
+// is the polynom id, the reply has no values.
+//
+// EVAL_OP_EVAL: the values are the points at which the polynom
+// _id is evaluated. the reply values are the results, in the
+// same order. _deadline_us, if not 0, is the time budget from
+// the request arrival. a request not started within its budget
+// is replied EVAL_STATUS_DEADLINE, without values.
+//
+// _tag is echoed in the reply, so that several requests may be
+// in flight on a connection. the reply _latency_ns is the time
+// from the request arrival to the reply, as seen by the server.
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "fdio.hh"
+
+
+enum evalOp
+{
+  EVAL_OP_REGISTER = 0,
+  EVAL_OP_EVAL
+};
+
+enum evalType
+{
+  EVAL_TYPE_MODP = 0,
+  EVAL_TYPE_DOUBLE
+};
+
+enum evalStatus
+{
+  EVAL_STATUS_OK = 0,
+  EVAL_STATUS_DEADLINE,
+  EVAL_STATUS_UNKNOWN_ID,
+  EVAL_STATUS_BAD_TYPE,
+  EVAL_STATUS_BAD_REQUEST
+};
+
+// largest value count of a request
+static const uint64_t eval_max_count = 1ULL << 28;
+
+
+struct evalRequest
+{
+  uint32_t _op;
+  uint32_t _type;
+  uint64_t _id;
+  uint64_t _count;
+  uint64_t _deadline_us;
+  uint64_t _tag;
+};
+
+struct evalReply
+{
+  uint32_t _status;
+  uint32_t _type;
+  uint64_t _id;
+  uint64_t _count;
+  uint64_t _latency_ns;
+  uint64_t _tag;
+};
+
+static inline int eval_parse_type(const char* s, uint32_t& type)
+{
+  if (strcmp(s, "modp") == 0) type = EVAL_TYPE_MODP;
+  else if (strcmp(s, "double") == 0) type = EVAL_TYPE_DOUBLE;
+  else return -1;
+  return 0;
+}
+
+
+// values travel as 8 bytes words
+
+static inline uint64_t eval_to_word(double d)
+{
+  uint64_t w;
+  memcpy(&w, &d, sizeof(w));
+  return w;
+}
+
+static inline uint64_t eval_to_word(unsigned long u)
+{ return (uint64_t)u; }
+
+static inline double eval_to_double(uint64_t w)
+{
+  double d;
+  memcpy(&d, &w, sizeof(d));
+  return d;
+}
+
+
+// blocking message io, -1 on error
+
+static inline int eval_send
+(int fd, const void* header, size_t size, const uint64_t* values,
+ uint64_t count)
+{
+  if (fd_write(fd, header, size) == -1) return -1;
+  if (count == 0) return 0;
+  return fd_write(fd, values, count * sizeof(uint64_t));
+}
+
+static inline int eval_send_request
+(int fd, const evalRequest& req, const uint64_t* values)
+{ return eval_send(fd, &req, sizeof(req), values, req._count); }
+
+static inline int eval_send_reply
+(int fd, const evalReply& rep, const uint64_t* values)
+{ return eval_send(fd, &rep, sizeof(rep), values, rep._count); }
+
+// read the values following a header into a malloced array
+static inline int eval_recv_values
+(int fd, uint64_t count, uint64_t** values)
+{
+  *values = NULL;
+  if (count == 0) return 0;
+  if (count > eval_max_count) return -1;
+
+  *values = (uint64_t*)malloc(count * sizeof(uint64_t));
+  if (fd_read(fd, *values, count * sizeof(uint64_t)) == -1)
+  {
+    free(*values);
+    *values = NULL;
+    return -1;
+  }
+
+  return 0;
+}
+
+
+// unix socket endpoints, -1 on error
+
+static inline int eval_address(const char* path, struct sockaddr_un& addr)
+{
+  if (strlen(path) >= sizeof(addr.sun_path))
+  {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  return 0;
+}
+
+static inline int eval_listen(const char* path)
+{
+  struct sockaddr_un addr;
+  if (eval_address(path, addr) == -1) return -1;
+
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1) return -1;
+
+  unlink(path);
+  if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == -1 ||
+      listen(fd, 64) == -1)
+  {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+static inline int eval_connect(const char* path)
+{
+  struct sockaddr_un addr;
+  if (eval_address(path, addr) == -1) return -1;
+
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1) return -1;
+
+  if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == -1)
+  {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+
+#endif // ! EVAL_PROTOCOL_HH_INCLUDED
@@ -0,0 +1,53 @@
+#ifndef FDIO_HH_INCLUDED
+# define FDIO_HH_INCLUDED
+
+
+// blocking read and write of a whole buffer on a descriptor.
+// -1 on error, errno being set. reading fails with EPIPE if the
+// peer closes before size bytes are read.
+
+
+#include <errno.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+
+static inline int fd_write(int fd, const void* buf, size_t size)
+{
+  for (size_t pos = 0; pos < size; )
+  {
+    const ssize_t n = write(fd, (const char*)buf + pos, size - pos);
+    if (n == -1)
+    {
+      if (errno == EINTR) continue ;
+      return -1;
+    }
+    pos += (size_t)n;
+  }
+  return 0;
+}
+
+static inline int fd_read(int fd, void* buf, size_t size)
+{
+  for (size_t pos = 0; pos < size; )
+  {
+    const ssize_t n = read(fd, (char*)buf + pos, size - pos);
+    if (n == -1)
+    {
+      if (errno == EINTR) continue ;
+      return -1;
+    }
+
+    if (n == 0)
+    {
+      errno = EPIPE;
+      return -1;
+    }
+
+    pos += (size_t)n;
+  }
+  return 0;
+}
+
+
+#endif // ! FDIO_HH_INCLUDED
@@ -0,0 +1,475 @@
+#ifndef FFT_HH_INCLUDED
+# define FFT_HH_INCLUDED
+
+
+// evaluation at the roots of unity. with w = exp(2i pi / N),
+// p(w^k) = sum(b[r] * w^(k r), r in [0, N[), b[r] being the sum
+// of the coefficients of the degrees r mod N. the folded b is
+// then transformed by a complex fft of size N, N a power of 2.
+//
+// the fft works on split real and imaginary arrays, so that the
+// butterflies vectorize. in cache sizes are radix 2. larger ones
+// recurse through the four step decomposition N = N1 * N2:
+// N2 ffts of size N1 on the transposed input, a twiddle by
+// w^(k1 r2), N1 ffts of size N2, and a final transpose. the
+// recursion makes it cache oblivious. at the top level the fft
+// batches and the transposes are linear works.
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <complex>
+#include "kaLinearWork.hh"
+
+
+// in cache transform size
+static const unsigned long fft_base_size = 1024;
+
+// sizes up to that run sequentially
+static const unsigned long fft_seq_size = 4096;
+
+
+// twiddles: _re[k][j] + i _im[k][j] = exp(2i pi j / 2^k), j < 2^(k - 1)
+
+struct fftPlan
+{
+  unsigned int _log;
+  double* _re[64];
+  double* _im[64];
+
+  fftPlan(unsigned long n)
+  {
+    _log = 0;
+    while ((1UL << _log) < n) ++_log;
+
+    for (unsigned int k = 1; k <= _log; ++k)
+    {
+      const unsigned long h = 1UL << (k - 1);
+      _re[k] = (double*)malloc(h * sizeof(double));
+      _im[k] = (double*)malloc(h * sizeof(double));
+      for (unsigned long j = 0; j < h; ++j)
+      {
+	const double t = M_PI * (double)j / (double)h;
+	_re[k][j] = cos(t);
+	_im[k][j] = sin(t);
+      }
+    }
+  }
+
+  ~fftPlan()
+  {
+    for (unsigned int k = 1; k <= _log; ++k)
+    {
+      free(_re[k]);
+      free(_im[k]);
+    }
+  }
+
+  // w_n^e, n = 2^k
+  void root(unsigned int k, unsigned long e, double& re, double& im) const
+  {
+    const unsigned long h = 1UL << (k - 1);
+    e &= 2 * h - 1;
+    if (e < h)
+    {
+      re = _re[k][e];
+      im = _im[k][e];
+    }
+    else
+    {
+      re = -_re[k][e - h];
+      im = -_im[k][e - h];
+    }
+  }
+
+private:
+
+  fftPlan(const fftPlan&);
+  fftPlan& operator=(const fftPlan&);
+};
+
+
+static inline unsigned int fft_log2(unsigned long n)
+{
+  unsigned int k = 0;
+  while ((1UL << k) < n) ++k;
+  return k;
+}
+
+static inline void fft_radix2
+(double* re, double* im, unsigned long n, const fftPlan& plan)
+{
+  // bit reversal permutation
+  for (unsigned long i = 1, j = 0; i < n; ++i)
+  {
+    unsigned long bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+
+    if (i < j)
+    {
+      const double tr = re[i]; re[i] = re[j]; re[j] = tr;
+      const double ti = im[i]; im[i] = im[j]; im[j] = ti;
+    }
+  }
+
+  unsigned int k = 1;
+  for (unsigned long h = 1; h < n; h *= 2, ++k)
+  {
+    const double* const wr = plan._re[k];
+    const double* const wi = plan._im[k];
+
+    for (unsigned long b = 0; b < n; b += 2 * h)
+    {
+      double* const lr = re + b;
+      double* const li = im + b;
+      double* const hr = re + b + h;
+      double* const hi = im + b + h;
+
+      for (unsigned long j = 0; j < h; ++j)
+      {
+	const double xr = hr[j] * wr[j] - hi[j] * wi[j];
+	const double xi = hr[j] * wi[j] + hi[j] * wr[j];
+	hr[j] = lr[j] - xr;
+	hi[j] = li[j] - xi;
+	lr[j] += xr;
+	li[j] += xi;
+      }
+    }
+  }
+}
+
+// dst[c][r] = src[r][c], src having nrows rows of ncols
+
+static inline void fft_transpose
+(
+ const double* sr, const double* si, double* dr, double* di,
+ unsigned long nrows, unsigned long ncols,
+ unsigned long r0, unsigned long r1
+)
+{
+  static const unsigned long bs = 32;
+
+  for (unsigned long rb = r0; rb < r1; rb += bs)
+  {
+    const unsigned long re = rb + bs < r1 ? rb + bs : r1;
+    for (unsigned long cb = 0; cb < ncols; cb += bs)
+    {
+      const unsigned long ce = cb + bs < ncols ? cb + bs : ncols;
+      for (unsigned long r = rb; r < re; ++r)
+	for (unsigned long c = cb; c < ce; ++c)
+	{
+	  dr[c * nrows + r] = sr[r * ncols + c];
+	  di[c * nrows + r] = si[r * ncols + c];
+	}
+    }
+  }
+}
+
+static void fft_seq(double*, double*, unsigned long, const fftPlan&);
+
+// fft of the row r, then the four step twiddle w_n^(r * k1)
+
+static inline void fft_row
+(
+ double* re, double* im, unsigned long r, unsigned long size,
+ unsigned int log_n, const fftPlan& plan
+)
+{
+  double* const rr = re + r * size;
+  double* const ri = im + r * size;
+
+  fft_seq(rr, ri, size, plan);
+
+  if (log_n == 0 || r == 0) return ;
+
+  for (unsigned long k = 1; k < size; ++k)
+  {
+    double wr, wi;
+    plan.root(log_n, r * k, wr, wi);
+    const double xr = rr[k] * wr - ri[k] * wi;
+    const double xi = rr[k] * wi + ri[k] * wr;
+    rr[k] = xr;
+    ri[k] = xi;
+  }
+}
+
+static void fft_seq
+(double* re, double* im, unsigned long n, const fftPlan& plan)
+{
+  if (n <= fft_base_size)
+  {
+    fft_radix2(re, im, n, plan);
+    return ;
+  }
+
+  const unsigned int log_n = fft_log2(n);
+  const unsigned long n1 = 1UL << (log_n / 2);
+  const unsigned long n2 = n / n1;
+
+  double* const tr = (double*)malloc(n * sizeof(double));
+  double* const ti = (double*)malloc(n * sizeof(double));
+
+  fft_transpose(re, im, tr, ti, n1, n2, 0, n1);
+  for (unsigned long r = 0; r < n2; ++r) fft_row(tr, ti, r, n1, log_n, plan);
+  fft_transpose(tr, ti, re, im, n2, n1, 0, n2);
+  for (unsigned long r = 0; r < n1; ++r) fft_row(re, im, r, n2, 0, plan);
+  fft_transpose(re, im, tr, ti, n1, n2, 0, n1);
+
+  memcpy(re, tr, n * sizeof(double));
+  memcpy(im, ti, n * sizeof(double));
+
+  free(tr);
+  free(ti);
+}
+
+
+class fftRowsWork : public ka::linearWork::baseWork
+{
+  // the work index r transforms the row r
+
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef ka::linearWork::voidResult result_type;
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 1;
+  static const unsigned int par_grain = 1;
+
+  double* _re;
+  double* _im;
+  unsigned long _size;
+  unsigned int _log_n;
+  const fftPlan* _plan;
+
+  fftRowsWork
+  (double* re, double* im, unsigned long nrows, unsigned long size,
+   unsigned int log_n, const fftPlan* plan)
+    : baseWork(0, nrows), _re(re), _im(im), _size(size),
+      _log_n(log_n), _plan(plan) {}
+
+  void initialize(const fftRowsWork& w)
+  {
+    _re = w._re;
+    _im = w._im;
+    _size = w._size;
+    _log_n = w._log_n;
+    _plan = w._plan;
+  }
+
+  void execute(result_type&, const range_type& r)
+  {
+    for (range_type::index_type i = r.begin(); i < r.end(); ++i)
+      fft_row(_re, _im, i, _size, _log_n, *_plan);
+  }
+
+  void reduce(result_type&, const result_type&, const range_type&) {}
+
+};
+
+class fftTransposeWork : public ka::linearWork::baseWork
+{
+  // the work index r is the source row r
+
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef ka::linearWork::voidResult result_type;
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 32;
+  static const unsigned int par_grain = 32;
+
+  const double* _sr;
+  const double* _si;
+  double* _dr;
+  double* _di;
+  unsigned long _nrows;
+  unsigned long _ncols;
+
+  fftTransposeWork
+  (const double* sr, const double* si, double* dr, double* di,
+   unsigned long nrows, unsigned long ncols)
+    : baseWork(0, nrows), _sr(sr), _si(si), _dr(dr), _di(di),
+      _nrows(nrows), _ncols(ncols) {}
+
+  void initialize(const fftTransposeWork& w)
+  {
+    _sr = w._sr;
+    _si = w._si;
+    _dr = w._dr;
+    _di = w._di;
+    _nrows = w._nrows;
+    _ncols = w._ncols;
+  }
+
+  void execute(result_type&, const range_type& r)
+  {
+    fft_transpose
+      (_sr, _si, _dr, _di, _nrows, _ncols, r.begin(), r.end());
+  }
+
+  void reduce(result_type&, const result_type&, const range_type&) {}
+
+};
+
+// in place fft, exponent sign +, n a power of 2
+
+static inline void fft_par
+(double* re, double* im, unsigned long n, const fftPlan& plan)
+{
+  if (n <= fft_seq_size)
+  {
+    fft_seq(re, im, n, plan);
+    return ;
+  }
+
+  const unsigned int log_n = fft_log2(n);
+  const unsigned long n1 = 1UL << (log_n / 2);
+  const unsigned long n2 = n / n1;
+
+  double* const tr = (double*)malloc(n * sizeof(double));
+  double* const ti = (double*)malloc(n * sizeof(double));
+
+  {
+    fftTransposeWork work(re, im, tr, ti, n1, n2);
+    ka::linearWork::execute(work);
+  }
+  {
+    fftRowsWork work(tr, ti, n2, n1, log_n, &plan);
+    ka::linearWork::execute(work);
+  }
+  {
+    fftTransposeWork work(tr, ti, re, im, n2, n1);
+    ka::linearWork::execute(work);
+  }
+  {
+    fftRowsWork work(re, im, n1, n2, 0, &plan);
+    ka::linearWork::execute(work);
+  }
+  {
+    fftTransposeWork work(re, im, tr, ti, n1, n2);
+    ka::linearWork::execute(work);
+  }
+
+  memcpy(re, tr, n * sizeof(double));
+  memcpy(im, ti, n * sizeof(double));
+
+  free(tr);
+  free(ti);
+}
+
+
+// fold the coefficients modulo N. thieves accumulate in their
+// own N array, added on reduction.
+
+class fftFoldWork;
+
+class fftFoldResult : public ka::linearWork::baseResult
+{
+public:
+  double* _b;
+  bool _is_owner;
+
+  fftFoldResult(double* b) : _b(b), _is_owner(false) {}
+
+  void initialize(const fftFoldWork&);
+};
+
+class fftFoldWork : public ka::linearWork::baseWork
+{
+  // the work index i folds a[i], of degree n - i
+
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef fftFoldResult result_type;
+
+  static const bool is_reducable = true;
+  static const unsigned int seq_grain = 4096;
+  static const unsigned int par_grain = 4096;
+  static const unsigned long seq_threshold = 64 * 1024;
+
+  const double* _a;
+  unsigned long _n;
+  unsigned long _N;
+
+  fftFoldWork(const double* a, unsigned long n, unsigned long N)
+    : baseWork(0, n + 1), _a(a), _n(n), _N(N) {}
+
+  void initialize(const fftFoldWork& w)
+  {
+    _a = w._a;
+    _n = w._n;
+    _N = w._N;
+  }
+
+  void execute(result_type& res, const range_type& r)
+  {
+    // N is a power of 2
+    const unsigned long mask = _N - 1;
+    for (range_type::index_type i = r.begin(); i < r.end(); ++i)
+      res._b[(_n - i) & mask] += _a[i];
+  }
+
+  void reduce(result_type& lhs, const result_type& rhs, const range_type&)
+  {
+    for (unsigned long r = 0; r < _N; ++r) lhs._b[r] += rhs._b[r];
+    if (rhs._is_owner) free(rhs._b);
+  }
+
+};
+
+inline void fftFoldResult::initialize(const fftFoldWork& w)
+{
+  _b = (double*)calloc(w._N, sizeof(double));
+  _is_owner = true;
+}
+
+
+// res[k] = p(exp(2i pi k / N)), k in [0, N[, N a power of 2
+
+static inline void fft_roots_par
+(const double* a, unsigned long n, unsigned long N, std::complex<double>* res)
+{
+  double* const re = (double*)calloc(N, sizeof(double));
+  double* const im = (double*)calloc(N, sizeof(double));
+
+  fftFoldWork work(a, n, N);
+  fftFoldResult fres(re);
+  ka::linearWork::execute(work, fres);
+
+  if (N > 1)
+  {
+    fftPlan plan(N);
+    fft_par(re, im, N, plan);
+  }
+
+  for (unsigned long k = 0; k < N; ++k)
+    res[k] = std::complex<double>(re[k], im[k]);
+
+  free(re);
+  free(im);
+}
+
+// x[k] == exp(2i pi k / m), m a power of 2
+
+static inline bool fft_are_roots
+(const std::complex<double>* x, unsigned long m)
+{
+  if (m == 0 || (m & (m - 1))) return false;
+
+  for (unsigned long k = 0; k < m; ++k)
+  {
+    const double t = 2. * M_PI * (double)k / (double)m;
+    if (fabs(x[k].real() - cos(t)) > 1E-12) return false;
+    if (fabs(x[k].imag() - sin(t)) > 1E-12) return false;
+  }
+
+  return true;
+}
+
+
+#endif // ! FFT_HH_INCLUDED
@@ -0,0 +1,143 @@
+#ifndef FIELD_HH_INCLUDED
+# define FIELD_HH_INCLUDED
+
+
+#include <math.h>
+#include <stdint.h>
+#include <complex>
+#include "modp.hh"
+
+
+// element types the generic kernels are instantiated on.
+// a field must implement:
+// typedef value_type;
+// value_type zero(), one();
+// value_type add(value_type, value_type);
+// value_type sub(value_type a, value_type b); // a - b
+// value_type mul(value_type, value_type);
+// value_type axb(value_type a, value_type x, value_type b); // a * x + b
+// value_type pow(value_type a, unsigned long n); // a^n
+
+
+struct modpField
+{
+  typedef unsigned long value_type;
+
+  static value_type zero() { return 0; }
+  static value_type one() { return 1; }
+
+  static value_type add(value_type a, value_type b)
+  { return add_modp(a, b); }
+
+  static value_type sub(value_type a, value_type b)
+  { return sub_modp(a, b); }
+
+  static value_type mul(value_type a, value_type b)
+  { return mul_modp(a, b); }
+
+  static value_type axb(value_type a, value_type x, value_type b)
+  { return axb_modp(a, x, b); }
+
+  static value_type pow(value_type a, unsigned long n)
+  { return pow_modp(a, n); }
+};
+
+
+struct doubleField
+{
+  typedef double value_type;
+
+  static value_type zero() { return 0.; }
+  static value_type one() { return 1.; }
+
+  static value_type add(value_type a, value_type b)
+  { return a + b; }
+
+  static value_type sub(value_type a, value_type b)
+  { return a - b; }
+
+  static value_type mul(value_type a, value_type b)
+  { return a * b; }
+
+  static value_type axb(value_type a, value_type x, value_type b)
+  { return a * x + b; }
+
+  static value_type pow(value_type a, unsigned long n)
+  { return ::pow(a, (double)n); }
+};
+
+
+struct complexField
+{
+  typedef std::complex<double> value_type;
+
+  static value_type zero() { return value_type(0., 0.); }
+  static value_type one() { return value_type(1., 0.); }
+
+  static value_type add(const value_type& a, const value_type& b)
+  { return a + b; }
+
+  static value_type sub(const value_type& a, const value_type& b)
+  { return a - b; }
+
+  static value_type mul(const value_type& a, const value_type& b)
+  { return a * b; }
+
+  static value_type axb
+  (const value_type& a, const value_type& x, const value_type& b)
+  { return a * x + b; }
+
+  static value_type pow(value_type a, unsigned long n)
+  {
+    value_type res = one();
+    for (; n; n >>= 1, a = a * a)
+      if (n & 1) res = res * a;
+    return res;
+  }
+};
+
+
+struct mersenne61Field
+{
+  // integers modulo the mersenne prime 2^61 - 1
+
+  typedef uint64_t value_type;
+
+  static const uint64_t prime = (1ULL << 61) - 1;
+
+  static value_type reduce(uint64_t a)
+  {
+    // a < 2^62
+    a = (a & prime) + (a >> 61);
+    return a >= prime ? a - prime : a;
+  }
+
+  static value_type zero() { return 0; }
+  static value_type one() { return 1; }
+
+  static value_type add(value_type a, value_type b)
+  { return reduce(a + b); }
+
+  static value_type sub(value_type a, value_type b)
+  { return reduce(a + prime - b); }
+
+  static value_type mul(value_type a, value_type b)
+  {
+    const __uint128_t p = (__uint128_t)a * b;
+    return reduce(((uint64_t)p & prime) + (uint64_t)(p >> 61));
+  }
+
+  static value_type axb(value_type a, value_type x, value_type b)
+  { return add(mul(a, x), b); }
+
+  static value_type pow(value_type a, unsigned long n)
+  {
+    value_type res = 1;
+    for (; n; n >>= 1, a = mul(a, a))
+      if (n & 1) res = mul(res, a);
+    return res;
+  }
+};
+
+
+#endif // ! FIELD_HH_INCLUDED
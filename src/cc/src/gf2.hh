@@ -0,0 +1,236 @@
+#ifndef GF2_HH_INCLUDED
+# define GF2_HH_INCLUDED
+
+
+// binary field arithmetics, see field.hh for the interface.
+// addition is xor. GF(2^64) and GF(2^128) multiply with carry
+// less multiplication (pclmulqdq) when available, and with a
+// portable shift and xor loop otherwise. GF(2^8) uses log and
+// exp tables. the representation is the polynomial basis.
+//
+// GF(2^64): x^64 + x^4 + x^3 + x + 1
+// GF(2^128): x^128 + x^7 + x^2 + x + 1
+// GF(2^8): x^8 + x^4 + x^3 + x^2 + 1, generator x
+
+
+#include <stdint.h>
+#include "horner.hh"
+
+#if defined(__PCLMUL__)
+# include <wmmintrin.h>
+#endif
+
+
+// 64 x 64 -> 128 carry less multiply
+
+static inline void clmul64
+(uint64_t a, uint64_t b, uint64_t& lo, uint64_t& hi)
+{
+#if defined(__PCLMUL__)
+  const __m128i p = _mm_clmulepi64_si128
+    (_mm_cvtsi64_si128((long long)a), _mm_cvtsi64_si128((long long)b), 0x00);
+  lo = (uint64_t)_mm_cvtsi128_si64(p);
+  hi = (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(p, p));
+#else
+  lo = 0;
+  hi = 0;
+  for (unsigned int i = 0; i < 64; ++i)
+  {
+    if (((b >> i) & 1) == 0) continue ;
+    lo ^= a << i;
+    if (i) hi ^= a >> (64 - i);
+  }
+#endif
+}
+
+
+struct gf2_64Field
+{
+  typedef uint64_t value_type;
+
+  static const uint64_t poly = 0x1b;
+
+  static value_type zero() { return 0; }
+  static value_type one() { return 1; }
+
+  static value_type add(value_type a, value_type b)
+  { return a ^ b; }
+
+  static value_type sub(value_type a, value_type b)
+  { return a ^ b; }
+
+  static value_type mul(value_type a, value_type b)
+  {
+    uint64_t lo, hi, tlo, thi;
+
+    clmul64(a, b, lo, hi);
+
+    // hi * x^64 = hi * poly, the product exceeds by 4 bits
+    clmul64(hi, poly, tlo, thi);
+    lo ^= tlo;
+    clmul64(thi, poly, tlo, thi);
+
+    return lo ^ tlo;
+  }
+
+  static value_type axb(value_type a, value_type x, value_type b)
+  { return mul(a, x) ^ b; }
+
+  static value_type pow(value_type a, unsigned long n)
+  {
+    value_type res = 1;
+    for (; n; n >>= 1, a = mul(a, a))
+      if (n & 1) res = mul(res, a);
+    return res;
+  }
+};
+
+
+struct gf128
+{
+  uint64_t _lo, _hi;
+
+  gf128() {}
+  gf128(uint64_t lo) : _lo(lo), _hi(0) {}
+  gf128(uint64_t lo, uint64_t hi) : _lo(lo), _hi(hi) {}
+
+  bool operator==(const gf128& rhs) const
+  { return _lo == rhs._lo && _hi == rhs._hi; }
+
+  bool operator!=(const gf128& rhs) const
+  { return !(*this == rhs); }
+};
+
+struct gf2_128Field
+{
+  typedef gf128 value_type;
+
+  static const uint64_t poly = 0x87;
+
+  static value_type zero() { return gf128(0, 0); }
+  static value_type one() { return gf128(1, 0); }
+
+  static value_type add(const value_type& a, const value_type& b)
+  { return gf128(a._lo ^ b._lo, a._hi ^ b._hi); }
+
+  static value_type sub(const value_type& a, const value_type& b)
+  { return add(a, b); }
+
+  static value_type mul(const value_type& a, const value_type& b)
+  {
+    // schoolbook product in 4 words, p0 the lowest
+    uint64_t p0, p1, p2, p3, tlo, thi;
+
+    clmul64(a._lo, b._lo, p0, p1);
+    clmul64(a._hi, b._hi, p2, p3);
+    clmul64(a._lo, b._hi, tlo, thi);
+    p1 ^= tlo; p2 ^= thi;
+    clmul64(a._hi, b._lo, tlo, thi);
+    p1 ^= tlo; p2 ^= thi;
+
+    // fold p3 * x^192 = p3 * poly * x^64
+    clmul64(p3, poly, tlo, thi);
+    p1 ^= tlo; p2 ^= thi;
+
+    // fold p2 * x^128 = p2 * poly
+    clmul64(p2, poly, tlo, thi);
+    p0 ^= tlo; p1 ^= thi;
+
+    return gf128(p0, p1);
+  }
+
+  static value_type axb
+  (const value_type& a, const value_type& x, const value_type& b)
+  { return add(mul(a, x), b); }
+
+  static value_type pow(value_type a, unsigned long n)
+  {
+    value_type res = one();
+    for (; n; n >>= 1, a = mul(a, a))
+      if (n & 1) res = mul(res, a);
+    return res;
+  }
+};
+
+
+struct gf2_8Tables
+{
+  uint8_t _log[256];
+  uint8_t _exp[512];
+
+  gf2_8Tables()
+  {
+    unsigned int v = 1;
+    for (unsigned int i = 0; i < 255; ++i)
+    {
+      _exp[i] = (uint8_t)v;
+      _exp[i + 255] = (uint8_t)v;
+      _log[v] = (uint8_t)i;
+      v <<= 1;
+      if (v & 0x100) v ^= 0x11d;
+    }
+    _exp[510] = _exp[0];
+    _exp[511] = _exp[1];
+    _log[0] = 0;
+  }
+};
+
+struct gf2_8Field
+{
+  typedef uint8_t value_type;
+
+  static const gf2_8Tables& tables()
+  {
+    static const gf2_8Tables t;
+    return t;
+  }
+
+  static value_type zero() { return 0; }
+  static value_type one() { return 1; }
+
+  static value_type add(value_type a, value_type b)
+  { return a ^ b; }
+
+  static value_type sub(value_type a, value_type b)
+  { return a ^ b; }
+
+  static value_type mul(value_type a, value_type b)
+  {
+    if (a == 0 || b == 0) return 0;
+    const gf2_8Tables& t = tables();
+    return t._exp[t._log[a] + t._log[b]];
+  }
+
+  static value_type axb(value_type a, value_type x, value_type b)
+  { return mul(a, x) ^ b; }
+
+  static value_type pow(value_type a, unsigned long n)
+  {
+    if (n == 0) return 1;
+    if (a == 0) return 0;
+    const gf2_8Tables& t = tables();
+    return t._exp[(t._log[a] * (n % 255)) % 255];
+  }
+};
+
+
+// the clmul fields are latency bound in a single horner chain
+
+template<>
+struct hornerKernel<gf2_64Field, uint64_t>
+{
+  static uint64_t run
+  (uint64_t res, uint64_t x, const uint64_t* a, unsigned long count)
+  { return horner_kernel_4way<gf2_64Field, uint64_t>(res, x, a, count); }
+};
+
+template<>
+struct hornerKernel<gf2_128Field, gf128>
+{
+  static gf128 run
+  (gf128 res, gf128 x, const gf128* a, unsigned long count)
+  { return horner_kernel_4way<gf2_128Field, gf128>(res, x, a, count); }
+};
+
+
+#endif // ! GF2_HH_INCLUDED
@@ -0,0 +1,178 @@
+#ifndef HORNER_HH_INCLUDED
+# define HORNER_HH_INCLUDED
+
+
+// horner evaluation over a generic field, see field.hh.
+// coefficients are stored highest degree first, a[0] being the
+// degree n coefficient. coef_type must convert to value_type.
+
+
+#include "kaLinearWork.hh"
+#include "field.hh"
+
+
+// sequential kernel: res * x^count + sum(a[i] * x^(count - 1 - i)).
+// fields may specialize it, see horner_kernel_4way.
+
+template<typename field_type, typename coef_type>
+struct hornerKernel
+{
+  typedef typename field_type::value_type value_type;
+
+  static value_type run
+  (value_type res, value_type x, const coef_type* a, unsigned long count)
+  {
+    for (unsigned long i = 0; i < count; ++i)
+      res = field_type::axb(res, x, a[i]);
+    return res;
+  }
+};
+
+template<typename field_type, typename coef_type>
+static typename field_type::value_type horner_kernel_4way
+(
+ typename field_type::value_type res,
+ typename field_type::value_type x,
+ const coef_type* a, unsigned long count
+)
+{
+  // 4 independent chains in x^4, for fields whose multiply
+  // latency is much higher than its throughput. the chain s
+  // accumulates the coefficients 4q + s, res seeds the chain 3.
+
+  typedef typename field_type::value_type value_type;
+
+  // leading coefficients, so that 4 divides the remaining count
+  const unsigned long head = count % 4;
+  for (unsigned long i = 0; i < head; ++i)
+    res = field_type::axb(res, x, a[i]);
+  a += head;
+  count -= head;
+
+  if (count == 0) return res;
+
+  const value_type x4 = field_type::pow(x, 4);
+
+  value_type h0 = a[0];
+  value_type h1 = a[1];
+  value_type h2 = a[2];
+  value_type h3 = field_type::axb(res, x4, a[3]);
+
+  for (unsigned long i = 4; i < count; i += 4)
+  {
+    h0 = field_type::axb(h0, x4, a[i + 0]);
+    h1 = field_type::axb(h1, x4, a[i + 1]);
+    h2 = field_type::axb(h2, x4, a[i + 2]);
+    h3 = field_type::axb(h3, x4, a[i + 3]);
+  }
+
+  return field_type::axb
+    (field_type::axb(field_type::axb(h0, x, h1), x, h2), x, h3);
+}
+
+
+template<typename field_type, typename coef_type>
+class hornerFieldWork;
+
+template<typename field_type, typename coef_type>
+class hornerFieldResult : public ka::linearWork::baseResult
+{
+public:
+  typedef typename field_type::value_type value_type;
+
+  value_type _res;
+
+  hornerFieldResult(value_type res) : _res(res) {}
+
+  void initialize(const hornerFieldWork<field_type, coef_type>&)
+  { _res = field_type::zero(); }
+};
+
+template<typename field_type, typename coef_type>
+class hornerFieldWork : public ka::linearWork::baseWork
+{
+  // the work index i processes the coefficient a[i + 1]
+
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef typename field_type::value_type value_type;
+  typedef hornerFieldResult<field_type, coef_type> result_type;
+
+  static const bool is_reducable = true;
+  static const unsigned int seq_grain = 1024;
+  static const unsigned int par_grain = 1024;
+  static const unsigned long seq_threshold = 4096;
+  static const bool is_tree_reducable = true;
+
+  value_type _x;
+  const coef_type* _a;
+
+  hornerFieldWork(value_type x, const coef_type* a, unsigned long n)
+    : baseWork(0, n), _x(x), _a(a) {}
+
+  // work indices [i, j[ only
+  hornerFieldWork
+  (value_type x, const coef_type* a, unsigned long i, unsigned long j)
+    : baseWork(i, j), _x(x), _a(a) {}
+
+  void initialize(const hornerFieldWork& w)
+  {
+    _x = w._x;
+    _a = w._a;
+  }
+
+  void execute(result_type& res, const range_type& r)
+  {
+    res._res = hornerKernel<field_type, coef_type>::run
+      (res._res, _x, _a + r.begin() + 1, r.size());
+  }
+
+  void reduce
+  (result_type& lhs, const result_type& rhs, const range_type& processed)
+  {
+    // lhs = lhs * x^n + rhs
+    lhs._res = field_type::add
+      (field_type::mul(lhs._res, field_type::pow(_x, processed.size())),
+       rhs._res);
+  }
+
+};
+
+
+template<typename field_type, typename coef_type>
+static typename field_type::value_type horner_par
+(typename field_type::value_type x, const coef_type* a, unsigned long n)
+{
+  hornerFieldWork<field_type, coef_type> work(x, a, n);
+  hornerFieldResult<field_type, coef_type> res(a[0]);
+  ka::linearWork::execute(work, res);
+  return res._res;
+}
+
+// evaluate the coefficients a[i + 1, j + 1[ from res, ie.
+// res * x^(j - i) + sum(a[k + 1] * x^(j - 1 - k), k in [i, j[)
+
+template<typename field_type, typename coef_type>
+static typename field_type::value_type horner_par_range
+(
+ typename field_type::value_type x, const coef_type* a,
+ unsigned long i, unsigned long j,
+ typename field_type::value_type res
+)
+{
+  hornerFieldWork<field_type, coef_type> work(x, a, i, j);
+  hornerFieldResult<field_type, coef_type> range_res(res);
+  ka::linearWork::execute(work, range_res);
+  return range_res._res;
+}
+
+template<typename field_type, typename coef_type>
+static typename field_type::value_type horner_seq
+(typename field_type::value_type x, const coef_type* a, unsigned long n)
+{
+  return hornerKernel<field_type, coef_type>::run(a[0], x, a + 1, n);
+}
+
+
+#endif // ! HORNER_HH_INCLUDED
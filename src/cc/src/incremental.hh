@@ -0,0 +1,247 @@
+#ifndef INCREMENTAL_HH_INCLUDED
+# define INCREMENTAL_HH_INCLUDED
+
+
+// maintained evaluation of a polynom at a fixed set of points,
+// under coefficient updates. the values p(x[j]) are cached. when
+// the coefficient of degree d changes by delta, p(x[j]) changes
+// by delta * x[j]^d, in O(1) per point with power tables: with
+// b = ceil(sqrt(n + 1)), x^d = x^(b * (d / b)) * x^(d % b), so
+// that each point holds 2 * b powers instead of n + 1.
+//
+// a batch of updates is applied in parallel over the points,
+// each point applying all the updates of the batch. the cost is
+// O(updates * points) instead of O(n * points) for a rerun.
+
+
+#include <math.h>
+#include <stdlib.h>
+#include "kaLinearWork.hh"
+#include "multipoint.hh"
+
+
+template<typename field_type>
+class incrementalTablesWork : public ka::linearWork::baseWork
+{
+  // the work index j builds the tables of the point j
+
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef ka::linearWork::voidResult result_type;
+  typedef typename field_type::value_type value_type;
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 16;
+  static const unsigned int par_grain = 16;
+
+  const value_type* _x;
+  unsigned long _b;
+  value_type* _lo;
+  value_type* _hi;
+
+  incrementalTablesWork
+  (const value_type* x, unsigned long m, unsigned long b,
+   value_type* lo, value_type* hi)
+    : baseWork(0, m), _x(x), _b(b), _lo(lo), _hi(hi) {}
+
+  void initialize(const incrementalTablesWork& w)
+  {
+    _x = w._x;
+    _b = w._b;
+    _lo = w._lo;
+    _hi = w._hi;
+  }
+
+  void execute(result_type&, const range_type& r)
+  {
+    for (range_type::index_type j = r.begin(); j < r.end(); ++j)
+    {
+      value_type* const lo = _lo + j * _b;
+      value_type* const hi = _hi + j * _b;
+
+      lo[0] = field_type::one();
+      for (unsigned long k = 1; k < _b; ++k)
+	lo[k] = field_type::mul(lo[k - 1], _x[j]);
+
+      const value_type xb = field_type::mul(lo[_b - 1], _x[j]);
+      hi[0] = field_type::one();
+      for (unsigned long k = 1; k < _b; ++k)
+	hi[k] = field_type::mul(hi[k - 1], xb);
+    }
+  }
+
+  void reduce(result_type&, const result_type&, const range_type&) {}
+
+};
+
+
+template<typename field_type>
+class incrementalUpdateWork : public ka::linearWork::baseWork
+{
+  // the work index j applies the batch to the point j
+
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef ka::linearWork::voidResult result_type;
+  typedef typename field_type::value_type value_type;
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 64;
+  static const unsigned int par_grain = 64;
+
+  unsigned long _b;
+  const value_type* _lo;
+  const value_type* _hi;
+  value_type* _values;
+
+  // degrees and deltas of the batch
+  const unsigned long* _degrees;
+  const value_type* _deltas;
+  unsigned long _count;
+
+  incrementalUpdateWork
+  (unsigned long m, unsigned long b, const value_type* lo,
+   const value_type* hi, value_type* values,
+   const unsigned long* degrees, const value_type* deltas,
+   unsigned long count)
+    : baseWork(0, m), _b(b), _lo(lo), _hi(hi), _values(values),
+      _degrees(degrees), _deltas(deltas), _count(count) {}
+
+  void initialize(const incrementalUpdateWork& w)
+  {
+    _b = w._b;
+    _lo = w._lo;
+    _hi = w._hi;
+    _values = w._values;
+    _degrees = w._degrees;
+    _deltas = w._deltas;
+    _count = w._count;
+  }
+
+  void execute(result_type&, const range_type& r)
+  {
+    for (range_type::index_type j = r.begin(); j < r.end(); ++j)
+    {
+      const value_type* const lo = _lo + j * _b;
+      const value_type* const hi = _hi + j * _b;
+
+      value_type v = _values[j];
+      for (unsigned long u = 0; u < _count; ++u)
+      {
+	const unsigned long d = _degrees[u];
+	const value_type xd = field_type::mul(hi[d / _b], lo[d % _b]);
+	v = field_type::axb(_deltas[u], xd, v);
+      }
+      _values[j] = v;
+    }
+  }
+
+  void reduce(result_type&, const result_type&, const range_type&) {}
+
+};
+
+
+// the coefficients are owned by the caller, highest degree first,
+// and must only be modified through update.
+
+template<typename field_type, typename coef_type = typename field_type::value_type>
+class incrementalEval
+{
+public:
+  typedef typename field_type::value_type value_type;
+
+  coef_type* _a;
+  unsigned long _n;
+
+  const value_type* _x;
+  unsigned long _m;
+
+  // cached p(x[j])
+  value_type* _values;
+
+  // x[j]^k and x[j]^(b * k), k in [0, b[
+  unsigned long _b;
+  value_type* _lo;
+  value_type* _hi;
+
+  // batch scratch
+  unsigned long* _degrees;
+  value_type* _deltas;
+  unsigned long _max_count;
+
+  incrementalEval
+  (coef_type* a, unsigned long n, const value_type* x, unsigned long m)
+    : _a(a), _n(n), _x(x), _m(m),
+      _degrees(NULL), _deltas(NULL), _max_count(0)
+  {
+    _b = (unsigned long)ceil(sqrt((double)(n + 1)));
+    while (_b * _b < n + 1) ++_b;
+
+    _values = (value_type*)malloc(m * sizeof(value_type));
+    _lo = (value_type*)malloc(m * _b * sizeof(value_type));
+    _hi = (value_type*)malloc(m * _b * sizeof(value_type));
+
+    if (m == 0) return ;
+
+    incrementalTablesWork<field_type> work(x, m, _b, _lo, _hi);
+    ka::linearWork::execute(work);
+
+    rebuild();
+  }
+
+  ~incrementalEval()
+  {
+    free(_values);
+    free(_lo);
+    free(_hi);
+    free(_degrees);
+    free(_deltas);
+  }
+
+  // full reevaluation, one pass over the coefficients
+  void rebuild()
+  { multipoint_par<field_type>(_x, _m, _a, _n, _values); }
+
+  // a[indices[u]] = coefs[u], u in [0, count[
+  void update
+  (const unsigned long* indices, const coef_type* coefs, unsigned long count)
+  {
+    if (count > _max_count)
+    {
+      _max_count = count;
+      _degrees = (unsigned long*)realloc
+	(_degrees, count * sizeof(unsigned long));
+      _deltas = (value_type*)realloc(_deltas, count * sizeof(value_type));
+    }
+
+    // deltas are computed in order, an index may repeat
+    for (unsigned long u = 0; u < count; ++u)
+    {
+      const unsigned long i = indices[u];
+      _degrees[u] = _n - i;
+      _deltas[u] = field_type::sub(coefs[u], _a[i]);
+      _a[i] = coefs[u];
+    }
+
+    if (_m == 0) return ;
+
+    incrementalUpdateWork<field_type> work
+      (_m, _b, _lo, _hi, _values, _degrees, _deltas, count);
+    ka::linearWork::execute(work);
+  }
+
+  void update(unsigned long index, const coef_type& coef)
+  { update(&index, &coef, 1); }
+
+  const value_type* values() const { return _values; }
+
+private:
+
+  incrementalEval(const incrementalEval&);
+  incrementalEval& operator=(const incrementalEval&);
+};
+
+
+#endif // ! INCREMENTAL_HH_INCLUDED
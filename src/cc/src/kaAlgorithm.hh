@@ -0,0 +1,451 @@
+#ifndef KA_ALGORITHM_HH_INCLUDED
+# define KA_ALGORITHM_HH_INCLUDED
+
+
+// stl like parallel algorithms on top of linearWork.
+// iterators must be random access. functors are shared by
+// pointer between the victim and the thieves, they must be
+// callable concurrently. value types carried in results are
+// copied with operator=, thus must not need construction.
+
+
+#include <iterator>
+#include "kaLinearWork.hh"
+#include "kaScan.hh"
+
+
+namespace ka {
+
+
+namespace algorithm {
+
+typedef ka::linearWork::range range_type;
+typedef ka::linearWork::voidResult voidResult;
+
+
+// for_each
+
+template<typename iterator_type, typename function_type>
+class forEachWork : public ka::linearWork::baseWork
+{
+public:
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 256;
+  static const unsigned int par_grain = 256;
+
+  iterator_type _first;
+  function_type* _f;
+
+  forEachWork(iterator_type first, range_type::size_type n, function_type* f)
+    : baseWork(0, n), _first(first), _f(f) {}
+
+  void initialize(const forEachWork& w)
+  {
+    _first = w._first;
+    _f = w._f;
+  }
+
+  void execute(voidResult&, const range_type& r)
+  {
+    iterator_type pos = _first + r.begin();
+    for (range_type::index_type i = r.begin(); i < r.end(); ++i, ++pos)
+      (*_f)(*pos);
+  }
+
+  void reduce(voidResult&, const voidResult&, const range_type&) {}
+
+};
+
+
+// transform
+
+template<typename input_type, typename output_type, typename function_type>
+class transformWork : public ka::linearWork::baseWork
+{
+public:
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 256;
+  static const unsigned int par_grain = 256;
+
+  input_type _first;
+  output_type _out;
+  function_type* _f;
+
+  transformWork
+  (input_type first, range_type::size_type n,
+   output_type out, function_type* f)
+    : baseWork(0, n), _first(first), _out(out), _f(f) {}
+
+  void initialize(const transformWork& w)
+  {
+    _first = w._first;
+    _out = w._out;
+    _f = w._f;
+  }
+
+  void execute(voidResult&, const range_type& r)
+  {
+    input_type ipos = _first + r.begin();
+    output_type opos = _out + r.begin();
+    for (range_type::index_type i = r.begin(); i < r.end(); ++i)
+      *opos++ = (*_f)(*ipos++);
+  }
+
+  void reduce(voidResult&, const voidResult&, const range_type&) {}
+
+};
+
+
+// transform_reduce. there is no neutral element, an empty
+// result is marked by _has_value == false.
+
+template<typename value_type>
+class valueResult : public ka::linearWork::baseResult
+{
+public:
+  value_type _value;
+  bool _has_value;
+
+  valueResult() : _has_value(false) {}
+
+  valueResult(const value_type& value)
+    : _value(value), _has_value(true) {}
+
+  template<typename work_type>
+  void initialize(const work_type&) { _has_value = false; }
+};
+
+template<typename iterator_type, typename value_type,
+	 typename reduce_type, typename transform_type>
+class transformReduceWork : public ka::linearWork::baseWork
+{
+public:
+
+  typedef valueResult<value_type> result_type;
+
+  static const bool is_reducable = true;
+  static const unsigned int seq_grain = 256;
+  static const unsigned int par_grain = 256;
+
+  iterator_type _first;
+  reduce_type* _reduce;
+  transform_type* _transform;
+
+  transformReduceWork
+  (iterator_type first, range_type::size_type n,
+   reduce_type* reduce, transform_type* transform)
+    : baseWork(0, n), _first(first),
+      _reduce(reduce), _transform(transform) {}
+
+  void initialize(const transformReduceWork& w)
+  {
+    _first = w._first;
+    _reduce = w._reduce;
+    _transform = w._transform;
+  }
+
+  void execute(result_type& res, const range_type& r)
+  {
+    iterator_type pos = _first + r.begin();
+    range_type::index_type i = r.begin();
+
+    if (res._has_value == false)
+    {
+      res._value = (*_transform)(*pos);
+      res._has_value = true;
+      ++pos; ++i;
+    }
+
+    value_type local_value = res._value;
+    for (; i < r.end(); ++i, ++pos)
+      local_value = (*_reduce)(local_value, (*_transform)(*pos));
+    res._value = local_value;
+  }
+
+  void reduce(result_type& lhs, const result_type& rhs, const range_type&)
+  {
+    if (rhs._has_value == false) return ;
+
+    if (lhs._has_value == false) lhs._value = rhs._value;
+    else lhs._value = (*_reduce)(lhs._value, rhs._value);
+    lhs._has_value = true;
+  }
+
+};
+
+
+// inclusive_scan. thieves scan from their first element, the
+// reductions record the carries and a fixup pass applies them.
+
+template<typename input_type, typename output_type,
+	 typename value_type, typename op_type>
+class scanWork : public ka::linearWork::baseWork
+{
+public:
+
+  typedef valueResult<value_type> result_type;
+  typedef ka::scan::segmentTable<value_type> table_type;
+
+  static const bool is_reducable = true;
+  static const unsigned int seq_grain = 256;
+  static const unsigned int par_grain = 256;
+
+  input_type _first;
+  output_type _out;
+  op_type* _op;
+  table_type* _table;
+
+  scanWork
+  (input_type first, range_type::size_type n,
+   output_type out, op_type* op, table_type* table)
+    : baseWork(0, n), _first(first), _out(out), _op(op), _table(table) {}
+
+  void initialize(const scanWork& w)
+  {
+    _first = w._first;
+    _out = w._out;
+    _op = w._op;
+    _table = w._table;
+  }
+
+  void execute(result_type& res, const range_type& r)
+  {
+    input_type ipos = _first + r.begin();
+    output_type opos = _out + r.begin();
+    range_type::index_type i = r.begin();
+
+    if (res._has_value == false)
+    {
+      res._value = *ipos++;
+      res._has_value = true;
+      *opos++ = res._value;
+      ++i;
+    }
+
+    value_type local_value = res._value;
+    for (; i < r.end(); ++i)
+    {
+      local_value = (*_op)(local_value, *ipos++);
+      *opos++ = local_value;
+    }
+    res._value = local_value;
+  }
+
+  void reduce
+  (result_type& lhs, const result_type& rhs, const range_type& processed)
+  {
+    if (rhs._has_value == false) return ;
+
+    if (lhs._has_value == false)
+    {
+      lhs._value = rhs._value;
+      lhs._has_value = true;
+      return ;
+    }
+
+    _table->push(processed, lhs._value);
+    lhs._value = (*_op)(lhs._value, rhs._value);
+  }
+
+};
+
+template<typename output_type, typename value_type, typename op_type>
+class scanFixupOp
+{
+public:
+  typedef ka::scan::segmentTable<value_type> table_type;
+  typedef typename table_type::segment_type segment_type;
+
+  output_type _out;
+  op_type* _op;
+
+  scanFixupOp(output_type out, op_type* op) : _out(out), _op(op) {}
+
+  void operator()
+  (const segment_type& s, range_type::index_type lo, range_type::index_type hi)
+  {
+    output_type pos = _out + lo;
+    for (; lo < hi; ++lo, ++pos) *pos = (*_op)(s._carry, *pos);
+  }
+};
+
+
+// find_if. the lowest matching index is shared, ranges
+// beginning after it are cancelled, including the ones
+// owned by thieves that are still running.
+
+template<typename iterator_type, typename predicate_type>
+class findIfWork : public ka::linearWork::baseWork
+{
+public:
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 256;
+  static const unsigned int par_grain = 256;
+
+  iterator_type _first;
+  predicate_type* _pred;
+  volatile range_type::index_type* _found;
+
+  findIfWork
+  (iterator_type first, range_type::size_type n,
+   predicate_type* pred, volatile range_type::index_type* found)
+    : baseWork(0, n), _first(first), _pred(pred), _found(found) {}
+
+  void initialize(const findIfWork& w)
+  {
+    _first = w._first;
+    _pred = w._pred;
+    _found = w._found;
+  }
+
+  bool is_cancelled() const
+  { return (range_type::index_type)_wq.beg >= *_found; }
+
+  void execute(voidResult&, const range_type& r)
+  {
+    iterator_type pos = _first + r.begin();
+    for (range_type::index_type i = r.begin(); i < r.end(); ++i, ++pos)
+    {
+      if ((*_pred)(*pos) == false) continue ;
+
+      // atomic min
+      range_type::index_type found = *_found;
+      while (i < found)
+      {
+	if (__sync_bool_compare_and_swap(_found, found, i)) break ;
+	found = *_found;
+      }
+
+      return ;
+    }
+  }
+
+  void reduce(voidResult&, const voidResult&, const range_type&) {}
+
+};
+
+
+template<typename predicate_type>
+struct notPredicate
+{
+  predicate_type* _pred;
+
+  notPredicate(predicate_type* pred) : _pred(pred) {}
+
+  template<typename value_type>
+  bool operator()(const value_type& value) const
+  { return (*_pred)(value) == false; }
+};
+
+
+} // ::algorithm
+
+
+template<typename iterator_type, typename function_type>
+static void for_each
+(iterator_type first, iterator_type last, function_type f)
+{
+  if (first == last) return ;
+
+  algorithm::forEachWork<iterator_type, function_type>
+    work(first, last - first, &f);
+  ka::linearWork::execute(work);
+}
+
+template<typename input_type, typename output_type, typename function_type>
+static output_type transform
+(input_type first, input_type last, output_type out, function_type f)
+{
+  if (first == last) return out;
+
+  algorithm::transformWork<input_type, output_type, function_type>
+    work(first, last - first, out, &f);
+  ka::linearWork::execute(work);
+
+  return out + (last - first);
+}
+
+template<typename iterator_type, typename value_type,
+	 typename reduce_type, typename transform_type>
+static value_type transform_reduce
+(iterator_type first, iterator_type last, value_type init,
+ reduce_type reduce, transform_type transform)
+{
+  if (first == last) return init;
+
+  algorithm::transformReduceWork
+    <iterator_type, value_type, reduce_type, transform_type>
+    work(first, last - first, &reduce, &transform);
+  algorithm::valueResult<value_type> res;
+  ka::linearWork::execute(work, res);
+
+  return reduce(init, res._value);
+}
+
+template<typename input_type, typename output_type, typename op_type>
+static output_type inclusive_scan
+(input_type first, input_type last, output_type out, op_type op)
+{
+  typedef typename std::iterator_traits<input_type>::value_type value_type;
+  typedef algorithm::scanWork<input_type, output_type, value_type, op_type>
+    work_type;
+  typedef algorithm::scanFixupOp<output_type, value_type, op_type>
+    fixup_type;
+
+  const algorithm::range_type::size_type n = last - first;
+  if (n == 0) return out;
+
+  typename work_type::table_type table(n);
+
+  work_type work(first, n, out, &op, &table);
+  algorithm::valueResult<value_type> res;
+  ka::linearWork::execute(work, res);
+
+  fixup_type fixup_op(out, &op);
+  ka::scan::fixup(table, fixup_op, n);
+
+  return out + n;
+}
+
+template<typename iterator_type, typename predicate_type>
+static iterator_type find_if
+(iterator_type first, iterator_type last, predicate_type pred)
+{
+  const algorithm::range_type::size_type n = last - first;
+  if (n == 0) return last;
+
+  volatile algorithm::range_type::index_type found = n;
+
+  algorithm::findIfWork<iterator_type, predicate_type>
+    work(first, n, &pred, &found);
+  ka::linearWork::execute(work);
+
+  return first + found;
+}
+
+template<typename iterator_type, typename predicate_type>
+static bool any_of
+(iterator_type first, iterator_type last, predicate_type pred)
+{ return ka::find_if(first, last, pred) != last; }
+
+template<typename iterator_type, typename predicate_type>
+static bool none_of
+(iterator_type first, iterator_type last, predicate_type pred)
+{ return ka::any_of(first, last, pred) == false; }
+
+template<typename iterator_type, typename predicate_type>
+static bool all_of
+(iterator_type first, iterator_type last, predicate_type pred)
+{
+  algorithm::notPredicate<predicate_type> not_pred(&pred);
+  return ka::any_of(first, last, not_pred) == false;
+}
+
+
+} // ka
+
+
+#endif // KA_ALGORITHM_HH_INCLUDED
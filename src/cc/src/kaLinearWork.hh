@@ -4,6 +4,9 @@
 
 #include <new>
 #include <cstdlib>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
 #include "kaapi.h"
 
 
@@ -29,6 +32,14 @@ struct range
 };
 
 
+// tree reduction states of a thief result
+enum resultState
+{
+  RESULT_RUNNING = 0,
+  RESULT_DONE,
+  RESULT_ABSORBED
+};
+
 // problem specific results must inherit from baseResult
 class baseResult
 {
@@ -36,10 +47,16 @@ public:
   range _range;
   bool _is_reduced;
 
-  baseResult() : _is_reduced(false) {}
+  // tree reduction: the result of the range following this one
+  baseResult* _tree_next;
+  volatile unsigned int _tree_state;
+
+  baseResult()
+    : _is_reduced(false), _tree_next(NULL), _tree_state(RESULT_RUNNING) {}
 
   baseResult(range::index_type i, range::index_type j)
-    : _range(i, j), _is_reduced(false) {}
+    : _range(i, j), _is_reduced(false),
+      _tree_next(NULL), _tree_state(RESULT_RUNNING) {}
 };
 
 class voidResult : public baseResult
@@ -62,17 +79,142 @@ public:
   // result_hack: for now, victim result is maintained here
   void* _res;
 
+  // tree reduction: the thief result following the remaining range
+  baseResult* _tree_next;
+
   // default traits
   static const bool is_reducable = true;
   static const unsigned int seq_grain = 1;
   static const unsigned int par_grain = 1;
 
-  baseWork(range::index_type i, range::index_type j)
+  // ranges up to seq_threshold run on the caller thread,
+  // see costModel. 0 means always enter the adaptive section.
+  static const unsigned long seq_threshold = 0;
+
+  // a finished thief absorbs the adjacent thief results that are
+  // finished too, so that the victim has fewer results to reduce.
+  // reduce then runs on thieves, with any pair of adjacent ranges.
+  static const bool is_tree_reducable = false;
+
+  baseWork(range::index_type i, range::index_type j) : _tree_next(NULL)
   { kaapi_workqueue_init(&_wq, i, j); }
 
+  // cooperative cancellation. once true, the remaining
+  // ranges are neither processed nor split anymore.
+  bool is_cancelled() const { return false; }
+
+  // called once the work has executed its last range, on the
+  // thread that executed it, to release per work resources.
+  // a thief preempted before it starts executes nothing and
+  // is not finalized, so resources are allocated on the
+  // first execute.
+  void finalize() {}
+
 }; // baseWork
 
 
+// thief result slots. kaapi_allocate_thief_result uses the slot
+// passed as data instead of allocating one per steal. each worker
+// keeps a list of cache line aligned slots per slot size. a slot
+// released by another worker is pushed on the remote list of its
+// owner, which takes the whole remote list once its local one is
+// empty. slots are kept across executions, never freed.
+
+static const unsigned long slab_line_size = 64;
+
+// slots allocated at once
+static const unsigned long slab_chunk_size = 16;
+
+struct slabList;
+
+struct slabSlot
+{
+  // the payload starts at the next cache line
+  slabSlot* _next;
+  slabList* _owner;
+};
+
+struct slabList
+{
+  // owner only
+  slabSlot* _local;
+
+  // pushed by the other workers
+  slabSlot* volatile _remote;
+
+} __attribute__((aligned(slab_line_size)));
+
+template<unsigned long data_size>
+struct slab
+{
+  static const unsigned long slot_size = slab_line_size +
+    (data_size + slab_line_size - 1) / slab_line_size * slab_line_size;
+
+  // the calling worker list
+  static __thread slabList* _list;
+
+  static void* allocate()
+  {
+    slabList* l = _list;
+
+    if (l == NULL)
+    {
+      void* p;
+      if (posix_memalign(&p, slab_line_size, sizeof(slabList))) abort();
+      l = new (p) slabList;
+      l->_local = NULL;
+      l->_remote = NULL;
+      _list = l;
+    }
+
+    if (l->_local == NULL)
+      l->_local = __sync_lock_test_and_set(&l->_remote, (slabSlot*)NULL);
+
+    if (l->_local == NULL)
+    {
+      void* p;
+      if (posix_memalign(&p, slab_line_size, slab_chunk_size * slot_size))
+	abort();
+
+      for (unsigned long k = 0; k < slab_chunk_size; ++k)
+      {
+	slabSlot* const s = (slabSlot*)((char*)p + k * slot_size);
+	s->_owner = l;
+	s->_next = l->_local;
+	l->_local = s;
+      }
+    }
+
+    slabSlot* const s = l->_local;
+    l->_local = s->_next;
+    return (char*)s + slab_line_size;
+  }
+
+  static void release(void* data)
+  {
+    slabSlot* const s = (slabSlot*)((char*)data - slab_line_size);
+    slabList* const l = s->_owner;
+
+    if (l == _list)
+    {
+      s->_next = l->_local;
+      l->_local = s;
+      return ;
+    }
+
+    slabSlot* head;
+    do
+    {
+      head = l->_remote;
+      s->_next = head;
+    } while (__sync_bool_compare_and_swap(&l->_remote, head, s) == false);
+  }
+};
+
+template<unsigned long data_size>
+__thread slabList* slab<data_size>::_list = NULL;
+
+
 // reducer
 template<typename work_type, typename result_type>
 static void common_reducer
@@ -87,7 +229,8 @@ static void common_reducer
   // reduce the thief result
   vw->reduce(*vr, *tr, processed);
 
-  // continue the thief work
+  // continue the thief work, followed by its thieves results
+  vw->_tree_next = ((baseResult*)tr)->_tree_next;
   kaapi_workqueue_set(&vw->_wq, tr->_range._i, tr->_range._j);
 }
 
@@ -114,6 +257,10 @@ static int victim_reducer
 {
   // called from the victim to reduce a thief result
 
+  // absorbed by the thief of the previous range
+  if (((baseResult*)tdata)->_tree_state == RESULT_ABSORBED)
+    return 0;
+
   if (((result_type*)tdata)->_is_reduced == false)
   {
     work_type* const vw = (work_type*)varg;
@@ -149,6 +296,10 @@ static int work_splitter
   kaapi_workqueue_index_t unit_size;
 
  redo_steal:
+  // the remaining work is not needed
+  if (vw->is_cancelled())
+    return 0;
+
   // do not steal if range size <= par_grain
   range_size = kaapi_workqueue_size(&vw->_wq);
   if (range_size <= work_type::par_grain)
@@ -167,11 +318,14 @@ static int work_splitter
   if (kaapi_workqueue_steal(&vw->_wq, &i, &j, nreq * unit_size))
     goto redo_steal;
 
+  // thieves are created from the highest range down
+  baseResult* next = vw->_tree_next;
+
   for (; nreq; --nreq, ++req, ++nrep, j -= unit_size)
   {
     // for reduction, a result is needed. take care of initializing it
-    kaapi_taskadaptive_result_t* const ktr =
-      kaapi_allocate_thief_result(req, sizeof(result_type), NULL);
+    kaapi_taskadaptive_result_t* const ktr = kaapi_allocate_thief_result
+      (req, sizeof(result_type), slab<sizeof(result_type)>::allocate());
 
     // initialize the thief work
     work_type* const tw = (work_type*)kaapi_reply_init_adaptive_task
@@ -187,11 +341,18 @@ static int work_splitter
     new (ktr->data) baseResult
       ((range::index_type)(j - unit_size), (range::index_type)j);
     ((result_type*)ktr->data)->initialize(*tw);
+
+    // a thief preempted before it runs hands next to the victim
+    tw->_tree_next = next;
+    ((baseResult*)ktr->data)->_tree_next = next;
+    next = (baseResult*)ktr->data;
     
     // reply head, preempt head
     kaapi_reply_pushhead_adaptive_task(sc, req);
   }
 
+  vw->_tree_next = next;
+
   return nrep;
 } // work_splitter
 
@@ -210,6 +371,49 @@ static int extract_seq
   return 0;
 }
 
+// tree reduction of a finished thief. only instantiated
+// for the works with the is_tree_reducable trait.
+
+template<bool is_tree_reducable>
+struct treeReducer
+{
+  template<typename work_type, typename result_type>
+  static void absorb(kaapi_stealcontext_t*, work_type&, result_type&) {}
+};
+
+template<>
+struct treeReducer<true>
+{
+  template<typename work_type, typename result_type>
+  static void absorb
+  (kaapi_stealcontext_t* sc, work_type& work, result_type& res)
+  {
+    // no more steals, _tree_next is stable
+    kaapi_steal_setsplitter(sc, NULL, NULL);
+    kaapi_synchronize_steal(sc);
+
+    // absorb the finished results that follow. a result is only
+    // absorbed by the thief of the previous range, which the victim
+    // preempts first, so it is never reduced concurrently.
+    baseResult* next;
+    while ((next = work._tree_next) != NULL &&
+	   __sync_bool_compare_and_swap
+	   (&next->_tree_state, RESULT_DONE, RESULT_ABSORBED))
+    {
+      const result_type& rhs = *(const result_type*)next;
+      const range processed(res._range.begin(), rhs._range.begin());
+      work.reduce(res, rhs, processed);
+      res._range = rhs._range;
+      work._tree_next = next->_tree_next;
+    }
+
+    baseResult& base = res;
+    base._tree_next = work._tree_next;
+    __sync_synchronize();
+    base._tree_state = RESULT_DONE;
+  }
+};
+
 template<typename work_type, typename result_type>
 static void thief_entrypoint
 (void* args, kaapi_thread_t* thread, kaapi_stealcontext_t* sc)
@@ -234,7 +438,8 @@ static void thief_entrypoint
   // set the splitter for this task
   kaapi_steal_setsplitter(sc, splitter, work);
 
-  while (extract_seq(work->_wq, seq_range, work_type::seq_grain) != -1)
+  while (work->is_cancelled() == false &&
+	 extract_seq(work->_wq, seq_range, work_type::seq_grain) != -1)
   {
     work->execute(*res, seq_range);
 
@@ -244,8 +449,15 @@ static void thief_entrypoint
     res->_range._i = (range::index_type)work->_wq.beg;
     res->_range._j = (range::index_type)work->_wq.end;
 
+    // the victim continues with the remaining range
+    ((baseResult*)res)->_tree_next = work->_tree_next;
+
     is_preempted = kaapi_preemptpoint(sc, reducer, NULL, NULL, 0, NULL);
-    if (is_preempted) return ;
+    if (is_preempted)
+    {
+      work->finalize();
+      return ;
+    }
 
     kaapi_steal_setsplitter(sc, splitter, work);
   }
@@ -256,11 +468,190 @@ static void thief_entrypoint
   res->_range._i = work->_wq.beg;
   res->_range._j = work->_wq.beg;
 
+  treeReducer<work_type::is_tree_reducable>::absorb(sc, *work, *res);
+
+  work->finalize();
+
 } // thief_entrypoint
 
 
+// cost model. entering and leaving the adaptive section costs
+// more than the whole sequential loop for small ranges. the
+// threshold defaults to the work trait and can be calibrated.
+
+template<typename work_type>
+struct costModel
+{
+  static range::size_type threshold;
+};
+
+template<typename work_type>
+range::size_type costModel<work_type>::threshold = work_type::seq_threshold;
+
+
+// warm workers. the first parallel execution resumes the workers,
+// which then keep spinning on steals between executions so that
+// the next one starts at once. a watcher thread parks them once
+// no execution has run for spin_ns. the next execution resumes
+// them again.
+
+struct warmPool
+{
+  pthread_mutex_t _lock;
+  pthread_cond_t _cond;
+  pthread_t _watcher;
+
+  bool _has_watcher;
+  bool _is_warm;
+  bool _is_stopped;
+
+  // executions in progress, end of the last one
+  unsigned int _ncalls;
+  uint64_t _last_ns;
+
+  // idle spin time before parking
+  uint64_t _spin_ns;
+};
+
+static warmPool& warm_pool()
+{
+  static warmPool pool =
+  {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, pthread_t(),
+    false, false, false, 0, 0, 1000000
+  };
+  return pool;
+}
+
+static void* warm_watcher(void*)
+{
+  warmPool& pool = warm_pool();
+
+  pthread_mutex_lock(&pool._lock);
+
+  while (pool._is_stopped == false)
+  {
+    if (pool._is_warm == false)
+    {
+      pthread_cond_wait(&pool._cond, &pool._lock);
+      continue ;
+    }
+
+    const uint64_t now = kaapi_get_elapsedns();
+    if (pool._ncalls == 0 && now - pool._last_ns >= pool._spin_ns)
+    {
+      kaapi_end_parallel(KAAPI_SCHEDFLAG_NOWAIT);
+      pool._is_warm = false;
+      continue ;
+    }
+
+    // sleep until the workers may have spun long enough
+    uint64_t ns = pool._spin_ns;
+    if (pool._ncalls == 0) ns -= now - pool._last_ns;
+
+    pthread_mutex_unlock(&pool._lock);
+    const struct timespec ts =
+      { (time_t)(ns / 1000000000), (long)(ns % 1000000000) };
+    nanosleep(&ts, NULL);
+    pthread_mutex_lock(&pool._lock);
+  }
+
+  pthread_mutex_unlock(&pool._lock);
+
+  return NULL;
+}
+
+static void warm_enter()
+{
+  warmPool& pool = warm_pool();
+
+  pthread_mutex_lock(&pool._lock);
+
+  ++pool._ncalls;
+
+  if (pool._is_warm == false)
+  {
+    kaapi_begin_parallel(KAAPI_SCHEDFLAG_DEFAULT);
+    pool._is_warm = true;
+
+    if (pool._has_watcher == false)
+    {
+      pool._is_stopped = false;
+      pool._has_watcher =
+	pthread_create(&pool._watcher, NULL, warm_watcher, NULL) == 0;
+    }
+
+    pthread_cond_signal(&pool._cond);
+  }
+
+  pthread_mutex_unlock(&pool._lock);
+}
+
+static void warm_leave()
+{
+  warmPool& pool = warm_pool();
+
+  pthread_mutex_lock(&pool._lock);
+  --pool._ncalls;
+  pool._last_ns = kaapi_get_elapsedns();
+  pthread_mutex_unlock(&pool._lock);
+}
+
+// idle spin time before the workers are parked
+static inline void warm_set_spin(uint64_t ns)
+{
+  warmPool& pool = warm_pool();
+
+  pthread_mutex_lock(&pool._lock);
+  pool._spin_ns = ns;
+  pthread_mutex_unlock(&pool._lock);
+}
+
+// park the workers and stop the watcher
+static void warm_stop()
+{
+  warmPool& pool = warm_pool();
+
+  pthread_mutex_lock(&pool._lock);
+
+  if (pool._is_warm)
+  {
+    kaapi_end_parallel(KAAPI_SCHEDFLAG_DEFAULT);
+    pool._is_warm = false;
+  }
+
+  const bool has_watcher = pool._has_watcher;
+  pool._is_stopped = true;
+  pool._has_watcher = false;
+  pthread_cond_signal(&pool._cond);
+
+  pthread_mutex_unlock(&pool._lock);
+
+  if (has_watcher) pthread_join(pool._watcher, NULL);
+}
+
+
 template<typename work_type, typename result_type>
-static void execute(work_type& work, result_type& res)
+static void execute_seq(work_type& work, result_type& res)
+{
+  // run on the caller thread, no adaptive section
+
+  range seq_range;
+
+  // result_hack
+  work._res = (void*)&res;
+
+  while (work.is_cancelled() == false &&
+	 extract_seq(work._wq, seq_range, work_type::seq_grain) != -1)
+    work.execute(res, seq_range);
+
+  work.finalize();
+
+} // execute_seq
+
+
+template<typename work_type, typename result_type>
+static void execute_par(work_type& work, result_type& res)
 {
   // todo: take into account work traits
   // to use the right flags
@@ -285,40 +676,215 @@ static void execute(work_type& work, result_type& res)
   // result_hack
   work._res = (void*)&res;
 
+  warm_enter();
+
   // enter adaptive section
   sc = kaapi_task_begin_adaptive(thread, sc_flags, splitter, &work);
 
  continue_work:
-  while (extract_seq(work._wq, seq_range, work_type::seq_grain) != -1)
+  while (work.is_cancelled() == false &&
+	 extract_seq(work._wq, seq_range, work_type::seq_grain) != -1)
     work.execute(res, seq_range);
 
   // preempt and reduce thieves
   if ((ktr = kaapi_get_thief_head(sc)) != NULL)
   {
+    // the result slot is free once reduced
+    void* const data = ktr->data;
     kaapi_preempt_thief
       (sc, ktr, (void*)&work, reducer, (void*)&work);
+    slab<sizeof(result_type)>::release(data);
     goto continue_work;
   }
 
   // wait for thieves
   kaapi_task_end_adaptive(sc);
 
+  work.finalize();
+
+  warm_leave();
+
+} // execute_par
+
+
+template<typename work_type, typename result_type>
+static void execute(work_type& work, result_type& res)
+{
+  const range::size_type size =
+    (range::size_type)kaapi_workqueue_size(&work._wq);
+
+  if (size <= costModel<work_type>::threshold || kaapi_getconcurrency() == 1)
+    execute_seq(work, res);
+  else
+    execute_par(work, res);
+
 } // execute
 
 
+template<typename work_type, typename result_type>
+static range::size_type calibrate
+(const work_type& work, const result_type& res, unsigned int iter = 10)
+{
+  // time the sequential and parallel versions on growing sizes
+  // of the work range. the threshold is the largest size where
+  // sequential is not slower. work and res are copied, not run.
+
+  const range::index_type i = (range::index_type)work._wq.beg;
+  const range::size_type max_size =
+    (range::size_type)kaapi_workqueue_size((kaapi_workqueue_t*)&work._wq);
+
+  range::size_type threshold = 0;
+
+  for (range::size_type size = work_type::par_grain; size <= max_size; size *= 2)
+  {
+    uint64_t seq_time = 0;
+    uint64_t par_time = 0;
+
+    for (unsigned int k = 0; k < iter; ++k)
+    {
+      work_type seq_work(work);
+      kaapi_workqueue_init(&seq_work._wq, i, i + size);
+      result_type seq_res(res);
+
+      const uint64_t seq_start = kaapi_get_elapsedns();
+      execute_seq(seq_work, seq_res);
+      seq_time += kaapi_get_elapsedns() - seq_start;
+
+      work_type par_work(work);
+      kaapi_workqueue_init(&par_work._wq, i, i + size);
+      result_type par_res(res);
+
+      const uint64_t par_start = kaapi_get_elapsedns();
+      execute_par(par_work, par_res);
+      par_time += kaapi_get_elapsedns() - par_start;
+    }
+
+    if (seq_time > par_time) break ;
+    threshold = size;
+  }
+
+  costModel<work_type>::threshold = threshold;
+
+  return threshold;
+
+} // calibrate
+
+
 // no result execute version
 template<typename work_type>
 static void execute(work_type& work)
 { voidResult res; execute(work, res); }
 
 
+// asynchronous execute. the execution is pushed as a task in
+// the caller thread frame and may be stolen by an idle worker,
+// which then runs its adaptive section. thieves of a pending
+// execution steal from whatever is running, so the tail of
+// one execution overlaps with the next ones. waiting for a
+// handle runs its execution on the caller if nobody took it
+// yet, so handles are waited for in any order.
+// work and res must live until the handle is waited for.
+
+enum asyncState
+{
+  ASYNC_PENDING = 0,
+  ASYNC_RUNNING,
+  ASYNC_DONE
+};
+
+template<typename work_type, typename result_type>
+struct asyncTask
+{
+  work_type* _work;
+  result_type* _res;
+  volatile unsigned int _state;
+};
+
+// run the execution unless the runtime or a waiter took it
+template<typename work_type, typename result_type>
+static void async_run(asyncTask<work_type, result_type>* task)
+{
+  if (__sync_bool_compare_and_swap
+      (&task->_state, ASYNC_PENDING, ASYNC_RUNNING) == false)
+    return ;
+
+  execute(*task->_work, *task->_res);
+
+  __sync_synchronize();
+  task->_state = ASYNC_DONE;
+}
+
+template<typename work_type, typename result_type>
+static void async_entrypoint(void* args, kaapi_thread_t*)
+{
+  async_run((asyncTask<work_type, result_type>*)args);
+}
+
+template<typename work_type, typename result_type>
+class asyncHandle
+{
+public:
+  asyncTask<work_type, result_type>* _task;
+
+  asyncHandle(asyncTask<work_type, result_type>* task) : _task(task) {}
+
+  bool is_done() const
+  {
+    if (_task->_state != ASYNC_DONE) return false;
+    __sync_synchronize();
+    return true;
+  }
+
+  // wait for this execution only
+  void wait()
+  {
+    async_run(_task);
+
+    // running on another worker
+    while (_task->_state != ASYNC_DONE)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#endif
+    }
+
+    __sync_synchronize();
+  }
+};
+
+template<typename work_type, typename result_type>
+static asyncHandle<work_type, result_type> execute_async
+(work_type& work, result_type& res)
+{
+  kaapi_thread_t* const thread = kaapi_self_thread();
+
+  asyncTask<work_type, result_type>* const task =
+    (asyncTask<work_type, result_type>*)kaapi_thread_pushdata
+    (thread, sizeof(asyncTask<work_type, result_type>));
+  task->_work = &work;
+  task->_res = &res;
+  task->_state = ASYNC_PENDING;
+
+  kaapi_task_t* const ktask = kaapi_thread_toptask(thread);
+  kaapi_task_init
+    (ktask, (kaapi_task_body_t)async_entrypoint<work_type, result_type>, task);
+  kaapi_thread_pushtask(thread);
+
+  return asyncHandle<work_type, result_type>(task);
+}
+
+// wait for every pending asynchronous execution
+static inline void wait_async()
+{ kaapi_sched_sync(); }
+
+
 namespace toRemove {
 // kaapi runtime constructors
 static void initialize(int ac = 0, char** av = 0)
 { kaapi_init(); }
 
 static void finalize()
-{ kaapi_finalize(); }
+{ warm_stop(); kaapi_finalize(); }
 
 } // ::toRemove
 
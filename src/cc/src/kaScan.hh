@@ -0,0 +1,209 @@
+#ifndef KA_SCAN_HH_INCLUDED
+# define KA_SCAN_HH_INCLUDED
+
+
+#include <stdlib.h>
+#include <algorithm>
+#include "kaLinearWork.hh"
+
+
+// parallel prefix support for linearWork.
+// thieves compute their prefixes starting from the neutral
+// element. each reduction records a segment, ie. the range
+// processed by the thief and the victim value (carry) at the
+// time of the reduction. the element k is then fixed up by
+// every segment containing it, innermost first. segments
+// nest but never partially overlap.
+
+
+namespace ka {
+namespace scan {
+
+
+typedef ka::linearWork::range range;
+
+
+template<typename carry_type>
+struct segment
+{
+  range::index_type _i, _j;
+  carry_type _carry;
+};
+
+
+template<typename carry_type>
+class segmentTable
+{
+  // segments are appended concurrently by reducers. storage is
+  // a lazily allocated list of chunks, since the steal count is
+  // only bounded by the range size.
+
+public:
+
+  typedef segment<carry_type> segment_type;
+
+  static const unsigned long chunk_size = 1024;
+
+  segment_type** _chunks;
+  unsigned long _nchunks;
+  volatile unsigned long _count;
+
+  // finalized state, sorted by begin
+  segment_type* _segs;
+  range::index_type* _max_end;
+
+  segmentTable(range::size_type n)
+  {
+    _nchunks = n / chunk_size + 1;
+    _chunks = (segment_type**)calloc(_nchunks, sizeof(segment_type*));
+    _count = 0;
+    _segs = NULL;
+    _max_end = NULL;
+  }
+
+  ~segmentTable()
+  {
+    for (unsigned long i = 0; i < _nchunks; ++i) free(_chunks[i]);
+    free(_chunks);
+    free(_segs);
+    free(_max_end);
+  }
+
+  void push(const range& r, const carry_type& carry)
+  {
+    if (r.size() == 0) return ;
+
+    const unsigned long pos = __sync_fetch_and_add(&_count, 1);
+    segment_type** const chunk = &_chunks[pos / chunk_size];
+
+    if (*chunk == NULL)
+    {
+      segment_type* const p = (segment_type*)
+	malloc(chunk_size * sizeof(segment_type));
+      if (__sync_bool_compare_and_swap(chunk, NULL, p) == false)
+	free(p);
+    }
+
+    segment_type& s = (*chunk)[pos % chunk_size];
+    s._i = r.begin();
+    s._j = r.end();
+    s._carry = carry;
+  }
+
+  unsigned long size() const { return _count; }
+
+  static bool compare(const segment_type& lhs, const segment_type& rhs)
+  { return lhs._i < rhs._i; }
+
+  void finalize()
+  {
+    // called once all the reductions are done
+
+    const unsigned long count = _count;
+
+    _segs = (segment_type*)realloc(_segs, count * sizeof(segment_type));
+    _max_end = (range::index_type*)realloc
+      (_max_end, count * sizeof(range::index_type));
+
+    for (unsigned long i = 0; i < count; ++i)
+      _segs[i] = _chunks[i / chunk_size][i % chunk_size];
+
+    std::sort(_segs, _segs + count, compare);
+
+    range::index_type max_end = 0;
+    for (unsigned long i = 0; i < count; ++i)
+    {
+      if (_segs[i]._j > max_end) max_end = _segs[i]._j;
+      _max_end[i] = max_end;
+    }
+  }
+
+  template<typename op_type>
+  void apply(const range& r, op_type& op) const
+  {
+    // call op(segment, lo, hi) for every segment intersecting
+    // r, in decreasing begin order so that inner segments are
+    // applied before their parents. [lo, hi[ is the intersection.
+
+    const unsigned long count = _count;
+
+    // first segment starting at or after r.end()
+    unsigned long pos = 0, hi = count;
+    while (pos < hi)
+    {
+      const unsigned long mid = (pos + hi) / 2;
+      if (_segs[mid]._i < r.end()) pos = mid + 1;
+      else hi = mid;
+    }
+
+    while (pos)
+    {
+      --pos;
+
+      // no segment before can reach r
+      if (_max_end[pos] <= r.begin()) break ;
+
+      const segment_type& s = _segs[pos];
+      if (s._j <= r.begin()) continue ;
+
+      op(s, std::max(s._i, r.begin()), std::min(s._j, r.end()));
+    }
+  }
+
+}; // segmentTable
+
+
+// fixup pass. op_type implements:
+// void operator()(const segment&, index_type lo, index_type hi);
+
+template<typename op_type>
+class fixupWork : public ka::linearWork::baseWork
+{
+public:
+
+  typedef ka::linearWork::range range_type;
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 1024;
+  static const unsigned int par_grain = 1024;
+
+  const typename op_type::table_type* _table;
+  op_type* _op;
+
+  fixupWork
+  (const typename op_type::table_type* table, op_type* op, range::size_type n)
+    : baseWork(0, n), _table(table), _op(op) {}
+
+  void initialize(const fixupWork& w)
+  {
+    _table = w._table;
+    _op = w._op;
+  }
+
+  void execute(ka::linearWork::voidResult&, const range_type& r)
+  { _table->apply(r, *_op); }
+
+  void reduce
+  (ka::linearWork::voidResult&, const ka::linearWork::voidResult&,
+   const range_type&)
+  {}
+
+};
+
+
+template<typename op_type>
+static void fixup
+(typename op_type::table_type& table, op_type& op, range::size_type n)
+{
+  table.finalize();
+  if (table.size() == 0) return ;
+
+  fixupWork<op_type> work(&table, &op, n);
+  ka::linearWork::execute(work);
+}
+
+
+} } // ka::scan
+
+
+#endif // KA_SCAN_HH_INCLUDED
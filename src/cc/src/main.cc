@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include "modp.hh"
 #include "kaLinearWork.hh"
+#include "random.hh"
 
 
 // index to degree mapping functions
@@ -66,6 +67,7 @@ public:
   static const bool is_reducable = true;
   static const unsigned int seq_grain = 256;
   static const unsigned int par_grain = 256;
+  static const unsigned long seq_threshold = 4096;
 
   void initialize(const hornerWork& w)
   {
@@ -107,8 +109,7 @@ static unsigned long* make_rand_polynom(unsigned long n)
   unsigned long* const a = (unsigned long*)malloc
     ((n + 1) * sizeof(unsigned long));
 
-  for (unsigned long i = 0; i <= n; ++i)
-    a[i] = modp(rand());
+  random_fill_par(a, n + 1, 0, randomModulo<unsigned long>(modp_p));
 
   return a;
 }
@@ -116,11 +117,19 @@ static unsigned long* make_rand_polynom(unsigned long n)
 int main(int ac, char** av)
 {
   static const unsigned long n = 1024 * 1024;
-  unsigned long* const a = make_rand_polynom(n);
   static const unsigned long x = 2;
 
   ka::linearWork::toRemove::initialize();
 
+  unsigned long* const a = make_rand_polynom(n);
+
+  // small degrees run on the caller thread
+  {
+    hornerWork work(x, a, n);
+    hornerResult res(a, n);
+    ka::linearWork::calibrate(work, res);
+  }
+
   volatile unsigned long sum_par = 0;
 
   uint64_t start = kaapi_get_elapsedns();
@@ -135,7 +144,46 @@ int main(int ac, char** av)
 
   uint64_t stop = kaapi_get_elapsedns();
   double par_time = (double)(stop - start) / (100 * 1E6);
-  printf("%u %lf %lu\n", kaapi_getconcurrency(), par_time, sum_par);
+
+  // same evaluations, pipelined
+  hornerWork* const works = (hornerWork*)malloc(100 * sizeof(hornerWork));
+  hornerResult* const results = (hornerResult*)malloc
+    (100 * sizeof(hornerResult));
+
+  typedef ka::linearWork::asyncHandle<hornerWork, hornerResult> handle_type;
+  handle_type* const handles = (handle_type*)malloc(100 * sizeof(handle_type));
+
+  volatile unsigned long sum_async = 0;
+
+  start = kaapi_get_elapsedns();
+
+  for (unsigned int iter = 0; iter < 100; ++iter)
+  {
+    new (&works[iter]) hornerWork(x, a, n);
+    new (&results[iter]) hornerResult(a, n);
+    new (&handles[iter]) handle_type
+      (ka::linearWork::execute_async(works[iter], results[iter]));
+  }
+
+  // each result is consumed as soon as its evaluation is done
+  for (unsigned int iter = 0; iter < 100; ++iter)
+  {
+    handles[iter].wait();
+    sum_async += results[iter]._res;
+  }
+
+  // pop the tasks left in the frame
+  ka::linearWork::wait_async();
+
+  stop = kaapi_get_elapsedns();
+  double async_time = (double)(stop - start) / (100 * 1E6);
+
+  printf("%u %lf %lf %lu == %lu\n", kaapi_getconcurrency(),
+	 par_time, async_time, sum_par, sum_async);
+
+  free(handles);
+  free(results);
+  free(works);
 
   ka::linearWork::toRemove::finalize();
 
@@ -0,0 +1,74 @@
+#ifndef MAPPED_FILE_HH_INCLUDED
+# define MAPPED_FILE_HH_INCLUDED
+
+
+// read only memory mapped file. errors are reported as -1,
+// errno being set by the failing system call.
+
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+class mappedFile
+{
+public:
+  const unsigned char* _data;
+  size_t _size;
+
+  mappedFile() : _data(NULL), _size(0) {}
+
+  ~mappedFile() { close(); }
+
+  int open(const char* path)
+  {
+    const int fd = ::open(path, O_RDONLY);
+    if (fd == -1) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+    {
+      ::close(fd);
+      return -1;
+    }
+
+    _size = (size_t)st.st_size;
+
+    // empty files can not be mapped
+    if (_size == 0)
+    {
+      ::close(fd);
+      return 0;
+    }
+
+    void* const p = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (p == MAP_FAILED)
+    {
+      _size = 0;
+      return -1;
+    }
+
+    madvise(p, _size, MADV_SEQUENTIAL);
+    _data = (const unsigned char*)p;
+
+    return 0;
+  }
+
+  void close()
+  {
+    if (_data != NULL) munmap((void*)_data, _size);
+    _data = NULL;
+    _size = 0;
+  }
+
+  const unsigned char* data() const { return _data; }
+  size_t size() const { return _size; }
+};
+
+
+#endif // ! MAPPED_FILE_HH_INCLUDED
@@ -0,0 +1,314 @@
+#ifndef MATRIX_POLY_HH_INCLUDED
+# define MATRIX_POLY_HH_INCLUDED
+
+
+// polynoms of dense square matrices, p(A). matrices are m x m,
+// row major. the coefficients are the usual arrays, highest
+// degree first, so that any polynom of the project applies.
+//
+// paterson stockmeyer: with s = ceil(sqrt(n + 1)), p(A) is a
+// horner in A^s whose coefficients are polynoms of degree < s
+// in A, ie. linear combinations of the cached I, A, .., A^(s-1).
+// that is s - 1 products for the powers plus n / s horner
+// products, instead of n.
+//
+// the product is a cache blocked gemm whose work range is the
+// set of tiles of the result. linear combinations are parallel
+// over the entries.
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "kaLinearWork.hh"
+#include "field.hh"
+
+
+static const unsigned long gemm_block_size = 64;
+
+
+template<typename field_type>
+class gemmWork : public ka::linearWork::baseWork
+{
+  // the work index t computes the tile t of C
+
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef ka::linearWork::voidResult result_type;
+  typedef typename field_type::value_type value_type;
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 1;
+  static const unsigned int par_grain = 1;
+
+  const value_type* _a;
+  const value_type* _b;
+  value_type* _c;
+  unsigned long _m;
+
+  // tiles per row
+  unsigned long _nt;
+
+  gemmWork
+  (const value_type* a, const value_type* b, value_type* c,
+   unsigned long m, unsigned long nt)
+    : baseWork(0, nt * nt), _a(a), _b(b), _c(c), _m(m), _nt(nt) {}
+
+  void initialize(const gemmWork& w)
+  {
+    _a = w._a;
+    _b = w._b;
+    _c = w._c;
+    _m = w._m;
+    _nt = w._nt;
+  }
+
+  void execute(result_type&, const range_type& r)
+  {
+    static const unsigned long bs = gemm_block_size;
+
+    for (range_type::index_type t = r.begin(); t < r.end(); ++t)
+    {
+      const unsigned long i0 = (t / _nt) * bs;
+      const unsigned long j0 = (t % _nt) * bs;
+      const unsigned long i1 = i0 + bs < _m ? i0 + bs : _m;
+      const unsigned long j1 = j0 + bs < _m ? j0 + bs : _m;
+
+      for (unsigned long i = i0; i < i1; ++i)
+	for (unsigned long j = j0; j < j1; ++j)
+	  _c[i * _m + j] = field_type::zero();
+
+      // the k blocks of A rows and B columns stay in cache
+      for (unsigned long k0 = 0; k0 < _m; k0 += bs)
+      {
+	const unsigned long k1 = k0 + bs < _m ? k0 + bs : _m;
+
+	for (unsigned long i = i0; i < i1; ++i)
+	{
+	  value_type* const ci = _c + i * _m;
+	  for (unsigned long k = k0; k < k1; ++k)
+	  {
+	    const value_type aik = _a[i * _m + k];
+	    const value_type* const bk = _b + k * _m;
+	    for (unsigned long j = j0; j < j1; ++j)
+	      ci[j] = field_type::axb(aik, bk[j], ci[j]);
+	  }
+	}
+      }
+    }
+  }
+
+  void reduce(result_type&, const result_type&, const range_type&) {}
+
+};
+
+// c = a * b, c distinct from a and b
+
+template<typename field_type>
+static void gemm_par
+(
+ const typename field_type::value_type* a,
+ const typename field_type::value_type* b,
+ typename field_type::value_type* c, unsigned long m
+)
+{
+  const unsigned long nt = (m + gemm_block_size - 1) / gemm_block_size;
+  gemmWork<field_type> work(a, b, c, m, nt);
+  ka::linearWork::execute(work);
+}
+
+
+// out = base + sum(coefs[i] * A^i, i in [0, count[). base may be
+// NULL. powers[i] is A^i for i >= 1, A^0 is the identity.
+
+template<typename field_type>
+class matrixCombineWork : public ka::linearWork::baseWork
+{
+  // the work index e is the entry e of out
+
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef ka::linearWork::voidResult result_type;
+  typedef typename field_type::value_type value_type;
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 1024;
+  static const unsigned int par_grain = 1024;
+
+  const value_type* _base;
+  const value_type* _coefs;
+  const value_type* const* _powers;
+  unsigned long _count;
+  unsigned long _m;
+  value_type* _out;
+
+  matrixCombineWork
+  (const value_type* base, const value_type* coefs,
+   const value_type* const* powers, unsigned long count,
+   unsigned long m, value_type* out)
+    : baseWork(0, m * m), _base(base), _coefs(coefs), _powers(powers),
+      _count(count), _m(m), _out(out) {}
+
+  void initialize(const matrixCombineWork& w)
+  {
+    _base = w._base;
+    _coefs = w._coefs;
+    _powers = w._powers;
+    _count = w._count;
+    _m = w._m;
+    _out = w._out;
+  }
+
+  void execute(result_type&, const range_type& r)
+  {
+    for (range_type::index_type e = r.begin(); e < r.end(); ++e)
+    {
+      value_type v = _base != NULL ? _base[e] : field_type::zero();
+      if (e / _m == e % _m) v = field_type::add(v, _coefs[0]);
+      for (unsigned long i = 1; i < _count; ++i)
+	v = field_type::axb(_coefs[i], _powers[i][e], v);
+      _out[e] = v;
+    }
+  }
+
+  void reduce(result_type&, const result_type&, const range_type&) {}
+
+};
+
+
+// A^k, computed on demand and kept for the next polynoms
+
+template<typename field_type>
+class matrixPowers
+{
+public:
+  typedef typename field_type::value_type value_type;
+
+  unsigned long _m;
+
+  // _powers[k] = A^k, k in [1, _count[. _powers[0] is unused
+  value_type** _powers;
+  unsigned long _count;
+  unsigned long _max_count;
+
+  matrixPowers(const value_type* a, unsigned long m)
+    : _m(m), _count(2), _max_count(2)
+  {
+    _powers = (value_type**)malloc(_max_count * sizeof(value_type*));
+    _powers[0] = NULL;
+    _powers[1] = (value_type*)malloc(m * m * sizeof(value_type));
+    memcpy(_powers[1], a, m * m * sizeof(value_type));
+  }
+
+  ~matrixPowers()
+  {
+    for (unsigned long k = 1; k < _count; ++k) free(_powers[k]);
+    free(_powers);
+  }
+
+  // A^k for all k <= max_k
+  const value_type* const* get(unsigned long max_k)
+  {
+    if (max_k + 1 > _max_count)
+    {
+      _max_count = max_k + 1;
+      _powers = (value_type**)realloc
+	(_powers, _max_count * sizeof(value_type*));
+    }
+
+    for (; _count <= max_k; ++_count)
+    {
+      _powers[_count] = (value_type*)malloc(_m * _m * sizeof(value_type));
+      gemm_par<field_type>
+	(_powers[_count - 1], _powers[1], _powers[_count], _m);
+    }
+
+    return _powers;
+  }
+
+private:
+
+  matrixPowers(const matrixPowers&);
+  matrixPowers& operator=(const matrixPowers&);
+};
+
+
+// res = p(A), p of degree n
+
+template<typename field_type, typename coef_type>
+static void matrix_poly_par
+(
+ matrixPowers<field_type>& powers, const coef_type* a, unsigned long n,
+ typename field_type::value_type* res
+)
+{
+  typedef typename field_type::value_type value_type;
+
+  const unsigned long m = powers._m;
+
+  unsigned long s = (unsigned long)ceil(sqrt((double)(n + 1)));
+  if (s == 0) s = 1;
+
+  // the chunk j has the degrees [j * s, (j + 1) * s[
+  const unsigned long q = n / s;
+
+  const value_type* const* const pw = powers.get(s);
+
+  value_type* const coefs = (value_type*)malloc(s * sizeof(value_type));
+  value_type* const tmp = (value_type*)malloc(m * m * sizeof(value_type));
+
+  // coefficients of the chunk j, by increasing degree
+  for (unsigned long i = 0; i < s; ++i)
+    coefs[i] = q * s + i <= n ? (value_type)a[n - q * s - i] : field_type::zero();
+
+  {
+    matrixCombineWork<field_type> work(NULL, coefs, pw, s, m, res);
+    ka::linearWork::execute(work);
+  }
+
+  for (unsigned long j = q; j; --j)
+  {
+    gemm_par<field_type>(res, pw[s], tmp, m);
+
+    for (unsigned long i = 0; i < s; ++i)
+      coefs[i] = a[n - (j - 1) * s - i];
+
+    matrixCombineWork<field_type> work(tmp, coefs, pw, s, m, res);
+    ka::linearWork::execute(work);
+  }
+
+  free(coefs);
+  free(tmp);
+}
+
+// horner with matrix operands, n products
+
+template<typename field_type, typename coef_type>
+static void matrix_poly_horner
+(
+ const typename field_type::value_type* A, unsigned long m,
+ const coef_type* a, unsigned long n,
+ typename field_type::value_type* res
+)
+{
+  typedef typename field_type::value_type value_type;
+
+  value_type* const tmp = (value_type*)malloc(m * m * sizeof(value_type));
+
+  for (unsigned long e = 0; e < m * m; ++e)
+    res[e] = e / m == e % m ? (value_type)a[0] : field_type::zero();
+
+  for (unsigned long i = 1; i <= n; ++i)
+  {
+    gemm_par<field_type>(res, A, tmp, m);
+    for (unsigned long e = 0; e < m * m; ++e)
+      res[e] = e / m == e % m ? field_type::add(tmp[e], a[i]) : tmp[e];
+  }
+
+  free(tmp);
+}
+
+
+#endif // ! MATRIX_POLY_HH_INCLUDED
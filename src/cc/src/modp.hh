@@ -4,9 +4,12 @@
 /* modp arithmetics
  */
 
+/* the modulus */
+static const unsigned long modp_p = 1001;
+
 static inline unsigned long modp
 (unsigned long n)
-{ return n % 1001; }
+{ return n % modp_p; }
 
 static inline unsigned long mul_modp
 (unsigned long a, unsigned long b)
@@ -22,6 +25,13 @@ static inline unsigned long add_modp
   return modp(a + b);
 }
 
+static inline unsigned long sub_modp
+(unsigned long a, unsigned long b)
+{
+  /* (a - b) mod p */
+  return modp(a + modp_p - modp(b));
+}
+
 static inline unsigned long pow_modp
 (unsigned long a, unsigned long n)
 {
@@ -0,0 +1,311 @@
+#ifndef MULTIPOINT_HH_INCLUDED
+# define MULTIPOINT_HH_INCLUDED
+
+
+// evaluation of one polynom at m points in a single pass over
+// the coefficients. the work range is the coefficient range, as
+// in horner.hh. a block of seq_grain coefficients is loaded once
+// and reused for all the points. results hold one value per
+// point: a thief allocates its own array, which is released
+// once reduced with lhs[k] = lhs[k] * x[k]^len + rhs[k].
+//
+// multipointBlockKernel runs a block of coefficients for all the
+// points. doubles use simd fma over several registers of points,
+// each coefficient being broadcast once per group of points. the
+// reduction computes the x[k]^len by squarings on blocks of points.
+//
+// multipointKernel selects the evaluation method by field. for
+// complex points that are the m roots of unity in order, m a
+// power of 2, the evaluation is a fft (see fft.hh).
+
+
+#include <stdlib.h>
+#include "kaLinearWork.hh"
+#include "horner.hh"
+#include "fft.hh"
+
+#if defined(__AVX512F__) || (defined(__AVX2__) && defined(__FMA__))
+# include <immintrin.h>
+#endif
+
+
+// res[k] = res[k] * x[k]^count + sum(a[i] * x[k]^(count - 1 - i))
+
+template<typename field_type, typename coef_type>
+struct multipointBlockKernel
+{
+  typedef typename field_type::value_type value_type;
+
+  static void run
+  (value_type* res, const value_type* x, unsigned long m,
+   const coef_type* a, unsigned long count)
+  {
+    for (unsigned long k = 0; k < m; ++k)
+      res[k] = hornerKernel<field_type, coef_type>::run(res[k], x[k], a, count);
+  }
+};
+
+template<>
+struct multipointBlockKernel<doubleField, double>
+{
+  // independent accumulators, hiding the fma latency
+  static const unsigned int nregs = 4;
+
+  static void run
+  (double* res, const double* x, unsigned long m,
+   const double* a, unsigned long count)
+  {
+    unsigned long k = 0;
+
+#if defined(__AVX512F__)
+
+    for (; k + 8 * nregs <= m; k += 8 * nregs)
+    {
+      __m512d r[nregs], xs[nregs];
+      for (unsigned int j = 0; j < nregs; ++j)
+      {
+	r[j] = _mm512_loadu_pd(res + k + 8 * j);
+	xs[j] = _mm512_loadu_pd(x + k + 8 * j);
+      }
+
+      for (unsigned long i = 0; i < count; ++i)
+      {
+	const __m512d c = _mm512_set1_pd(a[i]);
+	for (unsigned int j = 0; j < nregs; ++j)
+	  r[j] = _mm512_fmadd_pd(r[j], xs[j], c);
+      }
+
+      for (unsigned int j = 0; j < nregs; ++j)
+	_mm512_storeu_pd(res + k + 8 * j, r[j]);
+    }
+
+#elif defined(__AVX2__) && defined(__FMA__)
+
+    for (; k + 4 * nregs <= m; k += 4 * nregs)
+    {
+      __m256d r[nregs], xs[nregs];
+      for (unsigned int j = 0; j < nregs; ++j)
+      {
+	r[j] = _mm256_loadu_pd(res + k + 4 * j);
+	xs[j] = _mm256_loadu_pd(x + k + 4 * j);
+      }
+
+      for (unsigned long i = 0; i < count; ++i)
+      {
+	const __m256d c = _mm256_set1_pd(a[i]);
+	for (unsigned int j = 0; j < nregs; ++j)
+	  r[j] = _mm256_fmadd_pd(r[j], xs[j], c);
+      }
+
+      for (unsigned int j = 0; j < nregs; ++j)
+	_mm256_storeu_pd(res + k + 4 * j, r[j]);
+    }
+
+#endif
+
+    // scalar groups, then the remaining points
+    for (; k + nregs <= m; k += nregs)
+    {
+      double r[nregs];
+      for (unsigned int j = 0; j < nregs; ++j) r[j] = res[k + j];
+
+      for (unsigned long i = 0; i < count; ++i)
+	for (unsigned int j = 0; j < nregs; ++j)
+	  r[j] = r[j] * x[k + j] + a[i];
+
+      for (unsigned int j = 0; j < nregs; ++j) res[k + j] = r[j];
+    }
+
+    for (; k < m; ++k)
+      res[k] = hornerKernel<doubleField, double>::run(res[k], x[k], a, count);
+  }
+};
+
+
+// lhs[k] = lhs[k] * x[k]^e + rhs[k]. the powers are computed by
+// squarings over a block of points, a loop that vectorizes.
+
+template<typename field_type>
+static void multipoint_shift
+(
+ typename field_type::value_type* lhs,
+ const typename field_type::value_type* rhs,
+ const typename field_type::value_type* x, unsigned long m,
+ unsigned long e
+)
+{
+  typedef typename field_type::value_type value_type;
+
+  static const unsigned long bs = 64;
+
+  value_type pw[bs];
+  value_type s[bs];
+
+  for (unsigned long k0 = 0; k0 < m; k0 += bs)
+  {
+    const unsigned long nk = m - k0 < bs ? m - k0 : bs;
+
+    for (unsigned long q = 0; q < nk; ++q)
+    {
+      pw[q] = x[k0 + q];
+      s[q] = field_type::one();
+    }
+
+    for (unsigned long b = e; b; b >>= 1)
+    {
+      if (b & 1)
+	for (unsigned long q = 0; q < nk; ++q) s[q] = field_type::mul(s[q], pw[q]);
+      if (b > 1)
+	for (unsigned long q = 0; q < nk; ++q) pw[q] = field_type::mul(pw[q], pw[q]);
+    }
+
+    for (unsigned long q = 0; q < nk; ++q)
+      lhs[k0 + q] = field_type::axb(lhs[k0 + q], s[q], rhs[k0 + q]);
+  }
+}
+
+
+template<typename field_type, typename coef_type>
+class multipointWork;
+
+template<typename field_type, typename coef_type>
+class multipointResult : public ka::linearWork::baseResult
+{
+public:
+  typedef typename field_type::value_type value_type;
+
+  value_type* _res;
+
+  // _res was allocated by initialize
+  bool _is_owner;
+
+  multipointResult(value_type* res) : _res(res), _is_owner(false) {}
+
+  void initialize(const multipointWork<field_type, coef_type>& w)
+  {
+    _res = (value_type*)malloc(w._m * sizeof(value_type));
+    for (unsigned long k = 0; k < w._m; ++k) _res[k] = field_type::zero();
+    _is_owner = true;
+  }
+};
+
+template<typename field_type, typename coef_type>
+class multipointWork : public ka::linearWork::baseWork
+{
+  // the work index i processes the coefficient a[i + 1]
+
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef typename field_type::value_type value_type;
+  typedef multipointResult<field_type, coef_type> result_type;
+
+  static const bool is_reducable = true;
+  static const unsigned int seq_grain = 1024;
+  static const unsigned int par_grain = 1024;
+  static const bool is_tree_reducable = true;
+
+  const value_type* _x;
+  unsigned long _m;
+  const coef_type* _a;
+
+  multipointWork
+  (const value_type* x, unsigned long m, const coef_type* a, unsigned long n)
+    : baseWork(0, n), _x(x), _m(m), _a(a) {}
+
+  void initialize(const multipointWork& w)
+  {
+    _x = w._x;
+    _m = w._m;
+    _a = w._a;
+  }
+
+  void execute(result_type& res, const range_type& r)
+  {
+    multipointBlockKernel<field_type, coef_type>::run
+      (res._res, _x, _m, _a + r.begin() + 1, r.size());
+  }
+
+  void reduce
+  (result_type& lhs, const result_type& rhs, const range_type& processed)
+  {
+    multipoint_shift<field_type>
+      (lhs._res, rhs._res, _x, _m, processed.size());
+
+    if (rhs._is_owner) free(rhs._res);
+  }
+
+};
+
+
+// res[k] = p(x[k]), k in [0, m[, p of degree n
+
+template<typename field_type, typename coef_type>
+static void multipoint_horner_par
+(
+ const typename field_type::value_type* x, unsigned long m,
+ const coef_type* a, unsigned long n,
+ typename field_type::value_type* res
+)
+{
+  if (m == 0) return ;
+
+  for (unsigned long k = 0; k < m; ++k) res[k] = a[0];
+
+  multipointWork<field_type, coef_type> work(x, m, a, n);
+  multipointResult<field_type, coef_type> mres(res);
+  ka::linearWork::execute(work, mres);
+}
+
+template<typename field_type, typename coef_type>
+struct multipointKernel
+{
+  typedef typename field_type::value_type value_type;
+
+  static void run
+  (const value_type* x, unsigned long m, const coef_type* a,
+   unsigned long n, value_type* res)
+  { multipoint_horner_par<field_type, coef_type>(x, m, a, n, res); }
+};
+
+template<>
+struct multipointKernel<complexField, double>
+{
+  typedef complexField::value_type value_type;
+
+  static void run
+  (const value_type* x, unsigned long m, const double* a,
+   unsigned long n, value_type* res)
+  {
+    if (fft_are_roots(x, m))
+      fft_roots_par(a, n, m, res);
+    else
+      multipoint_horner_par<complexField, double>(x, m, a, n, res);
+  }
+};
+
+template<typename field_type, typename coef_type>
+static void multipoint_par
+(
+ const typename field_type::value_type* x, unsigned long m,
+ const coef_type* a, unsigned long n,
+ typename field_type::value_type* res
+)
+{
+  multipointKernel<field_type, coef_type>::run(x, m, a, n, res);
+}
+
+template<typename field_type, typename coef_type>
+static void multipoint_seq
+(
+ const typename field_type::value_type* x, unsigned long m,
+ const coef_type* a, unsigned long n,
+ typename field_type::value_type* res
+)
+{
+  for (unsigned long k = 0; k < m; ++k)
+    res[k] = horner_seq<field_type>(x[k], a, n);
+}
+
+
+#endif // ! MULTIPOINT_HH_INCLUDED
@@ -0,0 +1,274 @@
+#ifndef MULTIVARIATE_HH_INCLUDED
+# define MULTIVARIATE_HH_INCLUDED
+
+
+// dense multivariate polynom evaluation, nested horner. the
+// coefficients are a row major tensor of the nvars variables,
+// variable v having the degree n[v]. along each dimension, the
+// index 0 is the highest degree, as in horner.hh. points are
+// given by variable: x[v][p] is the variable v of the point p.
+//
+// p(x0, ...) = horner in x0 of the slices a[i0], themselves
+// polynoms of the remaining variables. a batch of points is
+// evaluated in a single pass over the tensor: each slice is
+// evaluated for all the points, the innermost rows being loaded
+// once and swept by blocks of points that the compiler can
+// vectorize. the work range is the set of outermost slices,
+// reduced as in horner with the x0^len shift per point.
+
+
+#include <stdlib.h>
+#include "kaLinearWork.hh"
+#include "field.hh"
+
+
+static const unsigned int multivariate_max_vars = 8;
+
+// points per innermost block
+static const unsigned int multivariate_block_size = 8;
+
+
+template<typename field_type>
+struct multivariatePolynom
+{
+  typedef typename field_type::value_type value_type;
+
+  unsigned int _nvars;
+  unsigned long _n[multivariate_max_vars];
+
+  // coefficients between 2 consecutive indices of a dimension
+  unsigned long _strides[multivariate_max_vars];
+
+  const value_type* _a;
+
+  void initialize(unsigned int nvars, const unsigned long* n, const value_type* a)
+  {
+    _nvars = nvars;
+    _a = a;
+
+    unsigned long stride = 1;
+    for (unsigned int v = nvars; v; --v)
+    {
+      _n[v - 1] = n[v - 1];
+      _strides[v - 1] = stride;
+      stride *= n[v - 1] + 1;
+    }
+  }
+
+  unsigned long size() const
+  { return _strides[0] * (_n[0] + 1); }
+};
+
+
+// innermost variable: out[p] = sum(a[k] * x[p]^(n - k))
+
+template<typename field_type>
+static void multivariate_inner
+(
+ const typename field_type::value_type* a, unsigned long n,
+ const typename field_type::value_type* x, unsigned long npoints,
+ typename field_type::value_type* out
+)
+{
+  typedef typename field_type::value_type value_type;
+  static const unsigned int w = multivariate_block_size;
+
+  unsigned long p = 0;
+
+  for (; p + w <= npoints; p += w)
+  {
+    value_type acc[w];
+    for (unsigned int q = 0; q < w; ++q) acc[q] = a[0];
+
+    for (unsigned long k = 1; k <= n; ++k)
+      for (unsigned int q = 0; q < w; ++q)
+	acc[q] = field_type::axb(acc[q], x[p + q], a[k]);
+
+    for (unsigned int q = 0; q < w; ++q) out[p + q] = acc[q];
+  }
+
+  // remaining points
+  for (; p < npoints; ++p)
+  {
+    value_type acc = a[0];
+    for (unsigned long k = 1; k <= n; ++k)
+      acc = field_type::axb(acc, x[p], a[k]);
+    out[p] = acc;
+  }
+}
+
+// the slice a of the variables [v, nvars[ at all the points.
+// tmp holds (nvars - v - 1) * npoints values.
+
+template<typename field_type>
+static void multivariate_slice
+(
+ const multivariatePolynom<field_type>& poly, unsigned int v,
+ const typename field_type::value_type* a,
+ const typename field_type::value_type* const* x, unsigned long npoints,
+ typename field_type::value_type* out, typename field_type::value_type* tmp
+)
+{
+  if (v + 1 == poly._nvars)
+  {
+    multivariate_inner<field_type>(a, poly._n[v], x[v], npoints, out);
+    return ;
+  }
+
+  const typename field_type::value_type* const xv = x[v];
+
+  multivariate_slice<field_type>(poly, v + 1, a, x, npoints, out, tmp + npoints);
+
+  for (unsigned long i = 1; i <= poly._n[v]; ++i)
+  {
+    multivariate_slice<field_type>
+      (poly, v + 1, a + i * poly._strides[v], x, npoints, tmp, tmp + npoints);
+    for (unsigned long p = 0; p < npoints; ++p)
+      out[p] = field_type::axb(out[p], xv[p], tmp[p]);
+  }
+}
+
+
+template<typename field_type>
+class multivariateWork;
+
+template<typename field_type>
+class multivariateResult : public ka::linearWork::baseResult
+{
+public:
+  typedef typename field_type::value_type value_type;
+
+  value_type* _res;
+
+  // _res was allocated by initialize
+  bool _is_owner;
+
+  multivariateResult(value_type* res) : _res(res), _is_owner(false) {}
+
+  void initialize(const multivariateWork<field_type>& w)
+  {
+    _res = (value_type*)malloc(w._npoints * sizeof(value_type));
+    for (unsigned long p = 0; p < w._npoints; ++p) _res[p] = field_type::zero();
+    _is_owner = true;
+  }
+};
+
+template<typename field_type>
+class multivariateWork : public ka::linearWork::baseWork
+{
+  // the work index i processes the outermost slice i
+
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef typename field_type::value_type value_type;
+  typedef multivariateResult<field_type> result_type;
+
+  static const bool is_reducable = true;
+  static const unsigned int seq_grain = 1;
+  static const unsigned int par_grain = 1;
+
+  const multivariatePolynom<field_type>* _poly;
+  const value_type* const* _x;
+  unsigned long _npoints;
+
+  // slice values, then the scratch of the inner levels
+  value_type* _tmp;
+
+  multivariateWork
+  (const multivariatePolynom<field_type>* poly,
+   const value_type* const* x, unsigned long npoints)
+    : baseWork(0, poly->_n[0] + 1), _poly(poly), _x(x),
+      _npoints(npoints), _tmp(NULL) {}
+
+  void initialize(const multivariateWork& w)
+  {
+    _poly = w._poly;
+    _x = w._x;
+    _npoints = w._npoints;
+    _tmp = NULL;
+  }
+
+  void finalize()
+  {
+    free(_tmp);
+    _tmp = NULL;
+  }
+
+  void execute(result_type& res, const range_type& r)
+  {
+    const multivariatePolynom<field_type>& poly = *_poly;
+
+    if (_tmp == NULL)
+      _tmp = (value_type*)malloc(poly._nvars * _npoints * sizeof(value_type));
+    value_type* const tmp = _tmp;
+
+    const value_type* const x0 = _x[0];
+
+    for (range_type::index_type i = r.begin(); i < r.end(); ++i)
+    {
+      if (poly._nvars == 1)
+	tmp[0] = poly._a[i];
+      else
+	multivariate_slice<field_type>
+	  (poly, 1, poly._a + i * poly._strides[0], _x, _npoints,
+	   tmp, tmp + _npoints);
+
+      for (unsigned long p = 0; p < _npoints; ++p)
+	res._res[p] = field_type::axb
+	  (res._res[p], x0[p], poly._nvars == 1 ? tmp[0] : tmp[p]);
+    }
+  }
+
+  void reduce
+  (result_type& lhs, const result_type& rhs, const range_type& processed)
+  {
+    for (unsigned long p = 0; p < _npoints; ++p)
+      lhs._res[p] = field_type::add
+	(field_type::mul
+	 (lhs._res[p], field_type::pow(_x[0][p], processed.size())),
+	 rhs._res[p]);
+
+    if (rhs._is_owner) free(rhs._res);
+  }
+
+};
+
+
+// res[p] = poly(x[0][p], ..., x[nvars - 1][p])
+
+template<typename field_type>
+static void multivariate_par
+(
+ const multivariatePolynom<field_type>& poly,
+ const typename field_type::value_type* const* x, unsigned long npoints,
+ typename field_type::value_type* res
+)
+{
+  if (npoints == 0) return ;
+
+  for (unsigned long p = 0; p < npoints; ++p) res[p] = field_type::zero();
+
+  multivariateWork<field_type> work(&poly, x, npoints);
+  multivariateResult<field_type> mres(res);
+  ka::linearWork::execute(work, mres);
+}
+
+template<typename field_type>
+static void multivariate_seq
+(
+ const multivariatePolynom<field_type>& poly,
+ const typename field_type::value_type* const* x, unsigned long npoints,
+ typename field_type::value_type* res
+)
+{
+  typedef typename field_type::value_type value_type;
+
+  value_type* const tmp = (value_type*)
+    malloc(poly._nvars * npoints * sizeof(value_type));
+  multivariate_slice<field_type>(poly, 0, poly._a, x, npoints, res, tmp);
+  free(tmp);
+}
+
+
+#endif // ! MULTIVARIATE_HH_INCLUDED
@@ -0,0 +1,162 @@
+#ifndef POLY_HASH_HH_INCLUDED
+# define POLY_HASH_HH_INCLUDED
+
+
+// polynomial hashing of byte streams modulo 2^61 - 1:
+// H(b) = sum(b[i] * x^(len - 1 - i)), ie. horner with the bytes
+// as coefficients. up to max_bases independent bases are hashed
+// in the same pass over the data. the length is part of the
+// state, since leading zero bytes do not change H.
+//
+// the hash of a concatenation is H(u.v) = H(u) * x^len(v) + H(v),
+// which is both the parallel reduction and the incremental
+// rehashing of appended data.
+
+
+#include <stdint.h>
+#include <string.h>
+#include "kaLinearWork.hh"
+#include "horner.hh"
+
+
+static const unsigned int poly_hash_max_bases = 4;
+
+// default bases, random values below 2^61 - 1
+static const uint64_t poly_hash_bases[poly_hash_max_bases] =
+{
+  0x0e3779b97f4a7c15ULL,
+  0x1f58476d1ce4e5b9ULL,
+  0x04cf5ad432745937ULL,
+  0x1b873593cc9e2d51ULL
+};
+
+
+struct polyHashState
+{
+  uint64_t _h[poly_hash_max_bases];
+  uint64_t _len;
+
+  void initialize()
+  {
+    memset(_h, 0, sizeof(_h));
+    _len = 0;
+  }
+
+  bool operator==(const polyHashState& rhs) const
+  {
+    return _len == rhs._len &&
+      memcmp(_h, rhs._h, sizeof(_h)) == 0;
+  }
+};
+
+
+class polyHashWork;
+
+class polyHashResult : public ka::linearWork::baseResult
+{
+public:
+  uint64_t _h[poly_hash_max_bases];
+
+  polyHashResult() { memset(_h, 0, sizeof(_h)); }
+
+  void initialize(const polyHashWork&) { memset(_h, 0, sizeof(_h)); }
+};
+
+class polyHashWork : public ka::linearWork::baseWork
+{
+public:
+
+  typedef ka::linearWork::range range_type;
+
+  static const bool is_reducable = true;
+  static const unsigned int seq_grain = 4096;
+  static const unsigned int par_grain = 4096;
+  static const unsigned long seq_threshold = 64 * 1024;
+
+  const unsigned char* _data;
+  unsigned int _nbases;
+
+  polyHashWork(const unsigned char* data, size_t size, unsigned int nbases)
+    : baseWork(0, size), _data(data), _nbases(nbases) {}
+
+  void initialize(const polyHashWork& w)
+  {
+    _data = w._data;
+    _nbases = w._nbases;
+  }
+
+  void execute(polyHashResult& res, const range_type& r)
+  {
+    // the chunk is in cache after the first base
+    for (unsigned int k = 0; k < _nbases; ++k)
+      res._h[k] = horner_kernel_4way<mersenne61Field, unsigned char>
+	(res._h[k], poly_hash_bases[k], _data + r.begin(), r.size());
+  }
+
+  void reduce
+  (polyHashResult& lhs, const polyHashResult& rhs, const range_type& processed)
+  {
+    for (unsigned int k = 0; k < _nbases; ++k)
+      lhs._h[k] = mersenne61Field::axb
+	(lhs._h[k],
+	 mersenne61Field::pow(poly_hash_bases[k], processed.size()),
+	 rhs._h[k]);
+  }
+
+};
+
+
+// extend state with data: state = H(previous data . data)
+
+static inline void poly_hash_extend
+(polyHashState& state, const unsigned char* data, size_t size,
+ unsigned int nbases = 1)
+{
+  if (size == 0) return ;
+
+  polyHashWork work(data, size, nbases);
+  polyHashResult res;
+  memcpy(res._h, state._h, sizeof(res._h));
+  ka::linearWork::execute(work, res);
+
+  memcpy(state._h, res._h, sizeof(state._h));
+  state._len += size;
+}
+
+// combine the states of two consecutive byte streams
+
+static inline void poly_hash_concat
+(polyHashState& lhs, const polyHashState& rhs, unsigned int nbases = 1)
+{
+  for (unsigned int k = 0; k < nbases; ++k)
+    lhs._h[k] = mersenne61Field::axb
+      (lhs._h[k], mersenne61Field::pow(poly_hash_bases[k], rhs._len),
+       rhs._h[k]);
+  lhs._len += rhs._len;
+}
+
+static inline void poly_hash
+(polyHashState& state, const unsigned char* data, size_t size,
+ unsigned int nbases = 1)
+{
+  state.initialize();
+  poly_hash_extend(state, data, size, nbases);
+}
+
+static inline void poly_hash_seq
+(polyHashState& state, const unsigned char* data, size_t size,
+ unsigned int nbases = 1)
+{
+  state.initialize();
+  for (unsigned int k = 0; k < nbases; ++k)
+  {
+    uint64_t h = 0;
+    for (size_t i = 0; i < size; ++i)
+      h = mersenne61Field::axb(h, poly_hash_bases[k], data[i]);
+    state._h[k] = h;
+  }
+  state._len = size;
+}
+
+
+#endif // ! POLY_HASH_HH_INCLUDED
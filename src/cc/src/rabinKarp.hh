@@ -0,0 +1,412 @@
+#ifndef RABIN_KARP_HH_INCLUDED
+# define RABIN_KARP_HH_INCLUDED
+
+
+// parallel multi pattern rabin karp search, with the polynomial
+// hash of polyHash.hh as the rolling hash. patterns are grouped
+// by length. the work range is the set of window positions. a
+// stolen range seeds the hash of its first window by horner,
+// then rolls: H(i + 1) = (H(i) - s[i] * x^(m - 1)) * x + s[i + m].
+// windows read m - 1 bytes past the range end, so ranges overlap
+// by that much and no match is lost at a split point. hash hits
+// are verified with memcmp.
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "kaLinearWork.hh"
+#include "field.hh"
+
+
+static const uint64_t rabin_karp_base = 0x0e3779b97f4a7c15ULL;
+
+
+struct rkMatch
+{
+  uint64_t _offset;
+  unsigned int _pattern;
+
+  bool operator<(const rkMatch& rhs) const
+  {
+    if (_offset != rhs._offset) return _offset < rhs._offset;
+    return _pattern < rhs._pattern;
+  }
+};
+
+
+// patterns of the same length
+
+struct rkGroup
+{
+  struct entry
+  {
+    uint64_t _hash;
+    unsigned int _pattern;
+
+    bool operator<(const entry& rhs) const { return _hash < rhs._hash; }
+  };
+
+  struct slot
+  {
+    uint64_t _hash;
+    unsigned int _first;
+    unsigned int _count;
+  };
+
+  size_t _len;
+
+  // x^(len - 1)
+  uint64_t _xm;
+
+  // entries sorted by hash, open addressing table on them
+  entry* _entries;
+  unsigned int _nentries;
+  slot* _slots;
+  uint64_t _mask;
+
+  const slot* find(uint64_t hash) const
+  {
+    for (uint64_t i = hash & _mask; ; i = (i + 1) & _mask)
+    {
+      if (_slots[i]._count == 0) return NULL;
+      if (_slots[i]._hash == hash) return &_slots[i];
+    }
+  }
+};
+
+
+class rkPatterns
+{
+public:
+  const unsigned char* const* _patterns;
+  const size_t* _lens;
+  unsigned int _npatterns;
+
+  rkGroup* _groups;
+  unsigned int _ngroups;
+
+  static uint64_t hash(const unsigned char* s, size_t len)
+  {
+    uint64_t h = 0;
+    for (size_t i = 0; i < len; ++i)
+      h = mersenne61Field::axb(h, rabin_karp_base, s[i]);
+    return h;
+  }
+
+  rkPatterns
+  (const unsigned char* const* patterns, const size_t* lens,
+   unsigned int npatterns)
+    : _patterns(patterns), _lens(lens), _npatterns(npatterns)
+  {
+    // patterns indices sorted by length
+    unsigned int* const order = (unsigned int*)
+      malloc(npatterns * sizeof(unsigned int));
+    for (unsigned int i = 0; i < npatterns; ++i) order[i] = i;
+    std::sort(order, order + npatterns, lenCompare(lens));
+
+    _groups = (rkGroup*)malloc(npatterns * sizeof(rkGroup));
+    _ngroups = 0;
+
+    for (unsigned int i = 0; i < npatterns; )
+    {
+      unsigned int j = i;
+      while (j < npatterns && lens[order[j]] == lens[order[i]]) ++j;
+
+      // empty patterns never match
+      if (lens[order[i]]) build_group(_groups[_ngroups++], order + i, j - i);
+
+      i = j;
+    }
+
+    free(order);
+  }
+
+  ~rkPatterns()
+  {
+    for (unsigned int i = 0; i < _ngroups; ++i)
+    {
+      free(_groups[i]._entries);
+      free(_groups[i]._slots);
+    }
+    free(_groups);
+  }
+
+private:
+
+  struct lenCompare
+  {
+    const size_t* _lens;
+    lenCompare(const size_t* lens) : _lens(lens) {}
+    bool operator()(unsigned int a, unsigned int b) const
+    { return _lens[a] < _lens[b]; }
+  };
+
+  void build_group(rkGroup& g, const unsigned int* order, unsigned int n)
+  {
+    g._len = _lens[order[0]];
+    g._xm = mersenne61Field::pow(rabin_karp_base, g._len - 1);
+
+    g._entries = (rkGroup::entry*)malloc(n * sizeof(rkGroup::entry));
+    g._nentries = n;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      g._entries[i]._hash = hash(_patterns[order[i]], g._len);
+      g._entries[i]._pattern = order[i];
+    }
+    std::sort(g._entries, g._entries + n);
+
+    uint64_t nslots = 2;
+    while (nslots < 2 * (uint64_t)n) nslots *= 2;
+    g._mask = nslots - 1;
+    g._slots = (rkGroup::slot*)calloc(nslots, sizeof(rkGroup::slot));
+
+    for (unsigned int i = 0; i < n; )
+    {
+      unsigned int j = i;
+      while (j < n && g._entries[j]._hash == g._entries[i]._hash) ++j;
+
+      uint64_t k = g._entries[i]._hash & g._mask;
+      while (g._slots[k]._count) k = (k + 1) & g._mask;
+      g._slots[k]._hash = g._entries[i]._hash;
+      g._slots[k]._first = i;
+      g._slots[k]._count = j - i;
+
+      i = j;
+    }
+  }
+};
+
+
+// matches are kept in order in a list of blocks. results only
+// hold pointers, since the runtime does not construct them.
+
+struct rkBlock
+{
+  static const unsigned int size = 256;
+
+  rkMatch _matches[size];
+  unsigned int _count;
+  rkBlock* _next;
+};
+
+class rkWork;
+
+class rkResult : public ka::linearWork::baseResult
+{
+public:
+  rkBlock* _head;
+  rkBlock* _tail;
+  uint64_t _count;
+
+  rkResult() : _head(NULL), _tail(NULL), _count(0) {}
+
+  void initialize(const rkWork&)
+  {
+    _head = NULL;
+    _tail = NULL;
+    _count = 0;
+  }
+
+  void push(uint64_t offset, unsigned int pattern)
+  {
+    if (_tail == NULL || _tail->_count == rkBlock::size)
+    {
+      rkBlock* const block = (rkBlock*)malloc(sizeof(rkBlock));
+      block->_count = 0;
+      block->_next = NULL;
+      if (_tail == NULL) _head = block;
+      else _tail->_next = block;
+      _tail = block;
+    }
+
+    rkMatch& m = _tail->_matches[_tail->_count++];
+    m._offset = offset;
+    m._pattern = pattern;
+  }
+
+  void release()
+  {
+    while (_head != NULL)
+    {
+      rkBlock* const next = _head->_next;
+      free(_head);
+      _head = next;
+    }
+    _tail = NULL;
+  }
+};
+
+class rkWork : public ka::linearWork::baseWork
+{
+public:
+
+  typedef ka::linearWork::range range_type;
+
+  static const bool is_reducable = true;
+  static const unsigned int seq_grain = 16 * 1024;
+  static const unsigned int par_grain = 16 * 1024;
+
+  const unsigned char* _data;
+  size_t _size;
+  const rkPatterns* _patterns;
+
+  // only count the matches
+  bool _is_count;
+
+  rkWork
+  (const unsigned char* data, size_t size,
+   const rkPatterns* patterns, bool is_count)
+    : baseWork(0, size), _data(data), _size(size),
+      _patterns(patterns), _is_count(is_count) {}
+
+  void initialize(const rkWork& w)
+  {
+    _data = w._data;
+    _size = w._size;
+    _patterns = w._patterns;
+    _is_count = w._is_count;
+  }
+
+  void execute(rkResult& res, const range_type& r)
+  {
+    for (unsigned int k = 0; k < _patterns->_ngroups; ++k)
+      execute_group(res, r, _patterns->_groups[k]);
+  }
+
+  void execute_group(rkResult& res, const range_type& r, const rkGroup& g)
+  {
+    if (g._len > _size) return ;
+
+    // last window position + 1
+    const uint64_t end =
+      r.end() < _size - g._len + 1 ? r.end() : _size - g._len + 1;
+    if (r.begin() >= end) return ;
+
+    const unsigned char* s = _data + r.begin();
+    uint64_t h = rkPatterns::hash(s, g._len);
+
+    for (uint64_t i = r.begin(); ; ++i, ++s)
+    {
+      const rkGroup::slot* const slot = g.find(h);
+      if (slot != NULL) match(res, g, *slot, s, i);
+
+      if (i + 1 == end) break ;
+
+      // roll
+      const uint64_t head = mersenne61Field::mul(s[0], g._xm);
+      h = mersenne61Field::add(h, mersenne61Field::prime - head);
+      h = mersenne61Field::axb(h, rabin_karp_base, s[g._len]);
+    }
+  }
+
+  void match
+  (rkResult& res, const rkGroup& g, const rkGroup::slot& slot,
+   const unsigned char* s, uint64_t offset)
+  {
+    for (unsigned int e = 0; e < slot._count; ++e)
+    {
+      const unsigned int p = g._entries[slot._first + e]._pattern;
+      if (memcmp(s, _patterns->_patterns[p], g._len)) continue ;
+
+      ++res._count;
+      if (_is_count == false) res.push(offset, p);
+    }
+  }
+
+  void reduce(rkResult& lhs, const rkResult& rhs, const range_type&)
+  {
+    lhs._count += rhs._count;
+
+    if (rhs._head == NULL) return ;
+
+    if (lhs._tail == NULL) lhs._head = rhs._head;
+    else lhs._tail->_next = rhs._head;
+    lhs._tail = rhs._tail;
+  }
+
+};
+
+
+// search the patterns in data. matches are returned sorted by
+// offset in a malloced array, or only counted if matches is NULL.
+
+static inline uint64_t rabin_karp_par
+(
+ const unsigned char* data, size_t size,
+ const rkPatterns& patterns, rkMatch** matches
+)
+{
+  rkWork work(data, size, &patterns, matches == NULL);
+  rkResult res;
+  ka::linearWork::execute(work, res);
+
+  if (matches == NULL) return res._count;
+
+  rkMatch* const m = (rkMatch*)malloc(res._count * sizeof(rkMatch));
+
+  uint64_t pos = 0;
+  for (const rkBlock* b = res._head; b != NULL; b = b->_next)
+  {
+    memcpy(m + pos, b->_matches, b->_count * sizeof(rkMatch));
+    pos += b->_count;
+  }
+
+  // groups are searched one after the other in a range
+  std::sort(m, m + res._count);
+
+  res.release();
+
+  *matches = m;
+  return res._count;
+}
+
+// naive reference, a memmem scan per pattern. same output
+// as rabin_karp_par.
+
+static inline uint64_t rabin_karp_seq
+(
+ const unsigned char* data, size_t size,
+ const rkPatterns& patterns, rkMatch** matches
+)
+{
+  uint64_t count = 0;
+  uint64_t capacity = 0;
+  rkMatch* m = NULL;
+
+  for (unsigned int k = 0; k < patterns._npatterns; ++k)
+  {
+    const size_t len = patterns._lens[k];
+    if (len == 0 || len > size) continue ;
+
+    const unsigned char* p = data;
+    while ((p = (const unsigned char*)memmem
+	    (p, size - (p - data), patterns._patterns[k], len)) != NULL)
+    {
+      if (matches != NULL)
+      {
+	if (count == capacity)
+	{
+	  capacity = capacity ? 2 * capacity : 256;
+	  m = (rkMatch*)realloc(m, capacity * sizeof(rkMatch));
+	}
+	m[count]._offset = (uint64_t)(p - data);
+	m[count]._pattern = k;
+      }
+
+      ++count;
+      ++p;
+    }
+  }
+
+  if (matches == NULL) return count;
+
+  std::sort(m, m + count);
+
+  *matches = m;
+  return count;
+}
+
+
+#endif // ! RABIN_KARP_HH_INCLUDED
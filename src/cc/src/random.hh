@@ -0,0 +1,155 @@
+#ifndef RANDOM_HH_INCLUDED
+# define RANDOM_HH_INCLUDED
+
+
+// counter based random arrays. the element i of a stream is a
+// function of the seed and i only, splitmix64 at the counter
+// key + (i + 1) * golden. arrays are filled in parallel and are
+// the same whatever the number of workers or the steals.
+//
+// a distribution maps the 64 bits word of an index to an element:
+// typedef value_type;
+// value_type draw(uint64_t key, unsigned long i) const;
+
+
+#include <stdint.h>
+#include "kaLinearWork.hh"
+
+
+static const uint64_t random_golden = 0x9e3779b97f4a7c15ULL;
+
+// splitmix64 output function
+static inline uint64_t random_mix(uint64_t z)
+{
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// distinct seeds give unrelated streams
+static inline uint64_t random_key(uint64_t seed)
+{ return random_mix(seed + random_golden); }
+
+static inline uint64_t random_word(uint64_t key, unsigned long i)
+{ return random_mix(key + (uint64_t)(i + 1) * random_golden); }
+
+
+// integers in [0, p[, by the high word of w * p. the bias is
+// below p / 2^64.
+
+template<typename value_type_>
+struct randomModulo
+{
+  typedef value_type_ value_type;
+
+  unsigned long _p;
+
+  randomModulo(unsigned long p) : _p(p) {}
+
+  value_type draw(uint64_t key, unsigned long i) const
+  {
+    const unsigned __int128 w = random_word(key, i);
+    return (value_type)(uint64_t)((w * _p) >> 64);
+  }
+};
+
+// doubles in [lo, hi[, 53 random bits
+
+struct randomUniform
+{
+  typedef double value_type;
+
+  double _lo;
+  double _hi;
+
+  randomUniform(double lo, double hi) : _lo(lo), _hi(hi) {}
+
+  value_type draw(uint64_t key, unsigned long i) const
+  {
+    const double u = (double)(random_word(key, i) >> 11) * (1. / 9007199254740992.);
+    return _lo + u * (_hi - _lo);
+  }
+};
+
+// the low bits of the word, for binary field elements
+
+template<typename value_type_>
+struct randomBits
+{
+  typedef value_type_ value_type;
+
+  value_type draw(uint64_t key, unsigned long i) const
+  { return (value_type)random_word(key, i); }
+};
+
+
+template<typename distribution_type>
+class randomFillWork : public ka::linearWork::baseWork
+{
+  // the work index i draws the element i
+
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef ka::linearWork::voidResult result_type;
+  typedef typename distribution_type::value_type value_type;
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 4096;
+  static const unsigned int par_grain = 4096;
+  static const unsigned long seq_threshold = 16 * 1024;
+
+  value_type* _a;
+  uint64_t _key;
+  const distribution_type* _dist;
+
+  randomFillWork
+  (value_type* a, unsigned long n, uint64_t key, const distribution_type* dist)
+    : baseWork(0, n), _a(a), _key(key), _dist(dist) {}
+
+  void initialize(const randomFillWork& w)
+  {
+    _a = w._a;
+    _key = w._key;
+    _dist = w._dist;
+  }
+
+  void execute(result_type&, const range_type& r)
+  {
+    for (range_type::index_type i = r.begin(); i < r.end(); ++i)
+      _a[i] = _dist->draw(_key, i);
+  }
+
+  void reduce(result_type&, const result_type&, const range_type&) {}
+
+};
+
+
+// a[i] = dist.draw(random_key(seed), i), i in [0, n[
+
+template<typename distribution_type>
+static void random_fill_par
+(
+ typename distribution_type::value_type* a, unsigned long n,
+ uint64_t seed, const distribution_type& dist
+)
+{
+  randomFillWork<distribution_type> work(a, n, random_key(seed), &dist);
+  ka::linearWork::execute(work);
+}
+
+// same values, no runtime needed
+
+template<typename distribution_type>
+static void random_fill_seq
+(
+ typename distribution_type::value_type* a, unsigned long n,
+ uint64_t seed, const distribution_type& dist
+)
+{
+  const uint64_t key = random_key(seed);
+  for (unsigned long i = 0; i < n; ++i) a[i] = dist.draw(key, i);
+}
+
+
+#endif // ! RANDOM_HH_INCLUDED
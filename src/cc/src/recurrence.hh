@@ -0,0 +1,434 @@
+#ifndef RECURRENCE_HH_INCLUDED
+# define RECURRENCE_HH_INCLUDED
+
+
+// k-th order linear recurrences. horner is the first order case:
+// its reduction composes the affine maps y -> y * x^n + b. here a
+// chunk is summarized by the affine map of its companion steps,
+// state' = M * state + v, and the reduction composes the maps.
+//
+// two users are provided:
+// . clenshaw evaluation of three term orthogonal series
+// (chebyshev, legendre), only the final state is needed,
+// . iir filtering, every output is needed. thieves filter from a
+// zero state and a fixup pass adds the homogeneous response to
+// the carried state, as for deflation.
+
+
+#include <string.h>
+#include "kaLinearWork.hh"
+#include "kaScan.hh"
+
+
+// state and affine map of a k-th order recurrence.
+// state[0] is the most recent value.
+
+template<unsigned int K>
+struct recurrenceState
+{
+  double _s[K];
+
+  void zero() { memset(_s, 0, sizeof(_s)); }
+};
+
+template<unsigned int K>
+struct affineMap
+{
+  double _m[K][K];
+  double _v[K];
+
+  void identity()
+  {
+    memset(_m, 0, sizeof(_m));
+    memset(_v, 0, sizeof(_v));
+    for (unsigned int i = 0; i < K; ++i) _m[i][i] = 1.;
+  }
+
+  void step(const double* c, double b)
+  {
+    // compose with the companion step:
+    // s'[0] = sum(c[i] * s[i]) + b, s'[i] = s[i - 1]
+
+    double row[K];
+    double v = b;
+
+    for (unsigned int j = 0; j < K; ++j) row[j] = 0.;
+    for (unsigned int i = 0; i < K; ++i)
+    {
+      for (unsigned int j = 0; j < K; ++j) row[j] += c[i] * _m[i][j];
+      v += c[i] * _v[i];
+    }
+
+    for (unsigned int i = K - 1; i > 0; --i)
+    {
+      for (unsigned int j = 0; j < K; ++j) _m[i][j] = _m[i - 1][j];
+      _v[i] = _v[i - 1];
+    }
+
+    for (unsigned int j = 0; j < K; ++j) _m[0][j] = row[j];
+    _v[0] = v;
+  }
+
+  void compose(const affineMap& rhs)
+  {
+    // this = rhs o this
+
+    affineMap res;
+
+    for (unsigned int i = 0; i < K; ++i)
+    {
+      res._v[i] = rhs._v[i];
+      for (unsigned int j = 0; j < K; ++j)
+      {
+	res._m[i][j] = 0.;
+	for (unsigned int k = 0; k < K; ++k)
+	  res._m[i][j] += rhs._m[i][k] * _m[k][j];
+	res._v[i] += rhs._m[i][j] * _v[j];
+      }
+    }
+
+    *this = res;
+  }
+
+  void apply(recurrenceState<K>& state) const
+  {
+    recurrenceState<K> res;
+    for (unsigned int i = 0; i < K; ++i)
+    {
+      res._s[i] = _v[i];
+      for (unsigned int j = 0; j < K; ++j)
+	res._s[i] += _m[i][j] * state._s[j];
+    }
+    state = res;
+  }
+};
+
+
+// generic evaluation work. step_type implements:
+// void operator()(unsigned long i, double* c, double& b) const;
+// giving the step coefficients at the work index i.
+
+template<unsigned int K>
+class recurrenceResult : public ka::linearWork::baseResult
+{
+public:
+  affineMap<K> _map;
+
+  recurrenceResult() { _map.identity(); }
+
+  template<typename work_type>
+  void initialize(const work_type&) { _map.identity(); }
+};
+
+template<unsigned int K, typename step_type>
+class recurrenceWork : public ka::linearWork::baseWork
+{
+public:
+
+  typedef ka::linearWork::range range_type;
+
+  static const bool is_reducable = true;
+  static const unsigned int seq_grain = 256;
+  static const unsigned int par_grain = 256;
+
+  const step_type* _step;
+
+  recurrenceWork(const step_type* step, unsigned long n)
+    : baseWork(0, n), _step(step) {}
+
+  void initialize(const recurrenceWork& w)
+  { _step = w._step; }
+
+  void execute(recurrenceResult<K>& res, const range_type& r)
+  {
+    double c[K];
+    double b;
+
+    for (range_type::index_type i = r.begin(); i < r.end(); ++i)
+    {
+      (*_step)(i, c, b);
+      res._map.step(c, b);
+    }
+  }
+
+  void reduce
+  (recurrenceResult<K>& lhs, const recurrenceResult<K>& rhs, const range_type&)
+  { lhs._map.compose(rhs._map); }
+
+};
+
+
+// clenshaw summation of sum(a_k * p_k(x)) for a three term
+// family p_k+1 = alpha_k * p_k + beta_k * p_k-1, p_0 = 1.
+// b_k = a_k + alpha_k * b_k+1 + beta_k+1 * b_k+2 for k = n..1,
+// then sum = a_0 + p_1 * b_1 + beta_1 * b_2.
+// coefficients are stored highest degree first, as for horner.
+
+struct chebyshevFamily
+{
+  static double alpha(unsigned long, double x) { return 2. * x; }
+  static double beta(unsigned long, double) { return -1.; }
+  static double p1(double x) { return x; }
+};
+
+struct legendreFamily
+{
+  static double alpha(unsigned long k, double x)
+  { return (double)(2 * k + 1) * x / (double)(k + 1); }
+
+  static double beta(unsigned long k, double)
+  { return -(double)k / (double)(k + 1); }
+
+  static double p1(double x) { return x; }
+};
+
+template<typename family_type>
+struct clenshawStep
+{
+  // work index i processes the degree k = n - i
+
+  double _x;
+  const double* _a;
+  unsigned long _n;
+
+  clenshawStep(double x, const double* a, unsigned long n)
+    : _x(x), _a(a), _n(n) {}
+
+  void operator()(unsigned long i, double* c, double& b) const
+  {
+    const unsigned long k = _n - i;
+    c[0] = family_type::alpha(k, _x);
+    c[1] = family_type::beta(k + 1, _x);
+    b = _a[i];
+  }
+};
+
+template<typename family_type>
+static double clenshaw_finalize
+(double x, const double* a, unsigned long n, const recurrenceState<2>& s)
+{
+  // s = (b_1, b_2)
+  return a[n] + family_type::p1(x) * s._s[0]
+    + family_type::beta(1, x) * s._s[1];
+}
+
+template<typename family_type>
+static double clenshaw_par(double x, const double* a, unsigned long n)
+{
+  if (n == 0) return a[0];
+
+  const clenshawStep<family_type> step(x, a, n);
+
+  recurrenceWork<2, clenshawStep<family_type> > work(&step, n);
+  recurrenceResult<2> res;
+  ka::linearWork::execute(work, res);
+
+  recurrenceState<2> s;
+  s.zero();
+  res._map.apply(s);
+
+  return clenshaw_finalize<family_type>(x, a, n, s);
+}
+
+template<typename family_type>
+static double clenshaw_seq(double x, const double* a, unsigned long n)
+{
+  double b1 = 0., b2 = 0.;
+
+  for (unsigned long i = 0; i < n; ++i)
+  {
+    const unsigned long k = n - i;
+    const double b0 = a[i] + family_type::alpha(k, x) * b1
+      + family_type::beta(k + 1, x) * b2;
+    b2 = b1;
+    b1 = b0;
+  }
+
+  return a[n] + family_type::p1(x) * b1 + family_type::beta(1, x) * b2;
+}
+
+
+// iir filtering:
+// y[t] = sum(b[i] * u[t - i], i = 0..Q) - sum(a[i] * y[t - i], i = 1..K)
+// a[0] is assumed to be 1. inputs and outputs before 0 are zero.
+
+template<unsigned int K>
+struct iirFilter
+{
+  // feedback coefficients, c[i] = -a[i + 1]
+  double _c[K];
+
+  // feedforward coefficients
+  const double* _b;
+  unsigned int _nb;
+
+  iirFilter(const double* a, const double* b, unsigned int nb)
+    : _b(b), _nb(nb)
+  { for (unsigned int i = 0; i < K; ++i) _c[i] = -a[i + 1]; }
+
+  double input(const double* u, unsigned long t) const
+  {
+    double w = 0.;
+    for (unsigned int i = 0; i < _nb && i <= t; ++i) w += _b[i] * u[t - i];
+    return w;
+  }
+
+  void step(recurrenceState<K>& s, double w) const
+  {
+    double y = w;
+    for (unsigned int i = 0; i < K; ++i) y += _c[i] * s._s[i];
+    for (unsigned int i = K - 1; i > 0; --i) s._s[i] = s._s[i - 1];
+    s._s[0] = y;
+  }
+
+  void companion_pow(unsigned long n, affineMap<K>& res) const
+  {
+    // the homogeneous map (v = 0) raised to n, by squaring
+
+    affineMap<K> p;
+    p.identity();
+    p.step(_c, 0.);
+
+    res.identity();
+    for (; n; n >>= 1)
+    {
+      if (n & 1) res.compose(p);
+      p.compose(p);
+    }
+  }
+};
+
+template<unsigned int K>
+class iirResult : public ka::linearWork::baseResult
+{
+public:
+  recurrenceState<K> _state;
+
+  iirResult() { _state.zero(); }
+
+  template<typename work_type>
+  void initialize(const work_type&) { _state.zero(); }
+};
+
+template<unsigned int K>
+class iirWork : public ka::linearWork::baseWork
+{
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef ka::scan::segmentTable< recurrenceState<K> > table_type;
+
+  static const bool is_reducable = true;
+  static const unsigned int seq_grain = 256;
+  static const unsigned int par_grain = 256;
+
+  const iirFilter<K>* _filter;
+  const double* _u;
+  double* _y;
+  table_type* _table;
+
+  iirWork
+  (const iirFilter<K>* filter, const double* u, double* y,
+   unsigned long n, table_type* table)
+    : baseWork(0, n), _filter(filter), _u(u), _y(y), _table(table) {}
+
+  void initialize(const iirWork& w)
+  {
+    _filter = w._filter;
+    _u = w._u;
+    _y = w._y;
+    _table = w._table;
+  }
+
+  void execute(iirResult<K>& res, const range_type& r)
+  {
+    recurrenceState<K> s = res._state;
+
+    for (range_type::index_type t = r.begin(); t < r.end(); ++t)
+    {
+      _filter->step(s, _filter->input(_u, t));
+      _y[t] = s._s[0];
+    }
+
+    res._state = s;
+  }
+
+  void reduce
+  (iirResult<K>& lhs, const iirResult<K>& rhs, const range_type& processed)
+  {
+    _table->push(processed, lhs._state);
+
+    // lhs = rhs + H^n * lhs
+    affineMap<K> h;
+    _filter->companion_pow(processed.size(), h);
+    h.apply(lhs._state);
+    for (unsigned int i = 0; i < K; ++i)
+      lhs._state._s[i] += rhs._state._s[i];
+  }
+
+};
+
+template<unsigned int K>
+class iirFixupOp
+{
+  // add the zero input response to the segment carry
+
+public:
+  typedef ka::scan::segmentTable< recurrenceState<K> > table_type;
+  typedef typename table_type::segment_type segment_type;
+
+  const iirFilter<K>* _filter;
+  double* _y;
+
+  iirFixupOp(const iirFilter<K>* filter, double* y)
+    : _filter(filter), _y(y) {}
+
+  void operator()
+  (const segment_type& seg, unsigned long lo, unsigned long hi)
+  {
+    recurrenceState<K> s = seg._carry;
+
+    affineMap<K> h;
+    _filter->companion_pow(lo - seg._i, h);
+    h.apply(s);
+
+    for (unsigned long t = lo; t < hi; ++t)
+    {
+      _filter->step(s, 0.);
+      _y[t] += s._s[0];
+    }
+  }
+};
+
+template<unsigned int K>
+static void iir_par
+(const iirFilter<K>& filter, const double* u, double* y, unsigned long n)
+{
+  if (n == 0) return ;
+
+  typename iirWork<K>::table_type table(n);
+
+  iirWork<K> work(&filter, u, y, n, &table);
+  iirResult<K> res;
+  ka::linearWork::execute(work, res);
+
+  iirFixupOp<K> op(&filter, y);
+  ka::scan::fixup(table, op, n);
+}
+
+template<unsigned int K>
+static void iir_seq
+(const iirFilter<K>& filter, const double* u, double* y, unsigned long n)
+{
+  recurrenceState<K> s;
+  s.zero();
+
+  for (unsigned long t = 0; t < n; ++t)
+  {
+    filter.step(s, filter.input(u, t));
+    y[t] = s._s[0];
+  }
+}
+
+
+#endif // ! RECURRENCE_HH_INCLUDED
@@ -0,0 +1,184 @@
+#ifndef SPARSE_HH_INCLUDED
+# define SPARSE_HH_INCLUDED
+
+
+// sparse polynom evaluation. a polynom is an array of (exponent,
+// coefficient) terms sorted by decreasing exponent, without
+// duplicates. the work index k processes the term k.
+//
+// horner with gaps: a range result is relative to the exponent of
+// the last term it processed, ie. sum(c[k] * x^(e[k] - e[last])).
+// moving to the term k multiplies by x^(e[k - 1] - e[k]). the
+// reduction likewise shifts the left result by the exponent gap
+// between the ends of both ranges, and the final result by the
+// exponent of the last term.
+
+
+#include "kaLinearWork.hh"
+#include "field.hh"
+
+
+template<typename coef_type>
+struct sparseTerm
+{
+  unsigned long _e;
+  coef_type _c;
+};
+
+
+// x^g: small gaps from a table, the others by squarings of x.
+// built once per evaluation, shared read only by the workers.
+
+template<typename field_type>
+struct sparsePowerCache
+{
+  typedef typename field_type::value_type value_type;
+
+  static const unsigned int small_size = 256;
+
+  value_type _small[small_size];
+
+  // x^(2^i)
+  value_type _pow2[64];
+
+  void initialize(value_type x)
+  {
+    _small[0] = field_type::one();
+    for (unsigned int i = 1; i < small_size; ++i)
+      _small[i] = field_type::mul(_small[i - 1], x);
+
+    _pow2[0] = x;
+    for (unsigned int i = 1; i < 64; ++i)
+      _pow2[i] = field_type::mul(_pow2[i - 1], _pow2[i - 1]);
+  }
+
+  value_type pow(unsigned long g) const
+  {
+    if (g < small_size) return _small[g];
+
+    // the low bits from the table
+    value_type res = _small[g % small_size];
+    g /= small_size;
+    for (unsigned int i = 8; g; g >>= 1, ++i)
+      if (g & 1) res = field_type::mul(res, _pow2[i]);
+    return res;
+  }
+};
+
+
+template<typename field_type, typename coef_type>
+class sparseWork;
+
+template<typename field_type, typename coef_type>
+class sparseResult : public ka::linearWork::baseResult
+{
+public:
+  typedef typename field_type::value_type value_type;
+
+  value_type _res;
+
+  sparseResult() : _res(field_type::zero()) {}
+
+  void initialize(const sparseWork<field_type, coef_type>&)
+  { _res = field_type::zero(); }
+};
+
+template<typename field_type, typename coef_type>
+class sparseWork : public ka::linearWork::baseWork
+{
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef typename field_type::value_type value_type;
+  typedef sparseResult<field_type, coef_type> result_type;
+
+  static const bool is_reducable = true;
+  static const unsigned int seq_grain = 512;
+  static const unsigned int par_grain = 512;
+  static const unsigned long seq_threshold = 2048;
+
+  const sparseTerm<coef_type>* _terms;
+  const sparsePowerCache<field_type>* _cache;
+
+  sparseWork
+  (const sparseTerm<coef_type>* terms, unsigned long nterms,
+   const sparsePowerCache<field_type>* cache)
+    : baseWork(0, nterms), _terms(terms), _cache(cache) {}
+
+  void initialize(const sparseWork& w)
+  {
+    _terms = w._terms;
+    _cache = w._cache;
+  }
+
+  void execute(result_type& res, const range_type& r)
+  {
+    range_type::index_type k = r.begin();
+
+    value_type v = res._res;
+
+    if (k == 0)
+    {
+      v = _terms[0]._c;
+      ++k;
+    }
+
+    for (; k < r.end(); ++k)
+      v = field_type::axb
+	(v, _cache->pow(_terms[k - 1]._e - _terms[k]._e), _terms[k]._c);
+
+    res._res = v;
+  }
+
+  void reduce
+  (result_type& lhs, const result_type& rhs, const range_type& processed)
+  {
+    if (processed.size() == 0) return ;
+
+    // lhs is relative to the term before processed
+    const unsigned long g =
+      _terms[processed.begin() - 1]._e - _terms[processed.end() - 1]._e;
+    lhs._res = field_type::axb(lhs._res, _cache->pow(g), rhs._res);
+  }
+
+};
+
+
+template<typename field_type, typename coef_type>
+static typename field_type::value_type sparse_horner_par
+(
+ typename field_type::value_type x,
+ const sparseTerm<coef_type>* terms, unsigned long nterms
+)
+{
+  if (nterms == 0) return field_type::zero();
+
+  sparsePowerCache<field_type> cache;
+  cache.initialize(x);
+
+  sparseWork<field_type, coef_type> work(terms, nterms, &cache);
+  sparseResult<field_type, coef_type> res;
+  ka::linearWork::execute(work, res);
+
+  return field_type::mul(res._res, cache.pow(terms[nterms - 1]._e));
+}
+
+template<typename field_type, typename coef_type>
+static typename field_type::value_type sparse_horner_seq
+(
+ typename field_type::value_type x,
+ const sparseTerm<coef_type>* terms, unsigned long nterms
+)
+{
+  if (nterms == 0) return field_type::zero();
+
+  typename field_type::value_type res = terms[0]._c;
+  for (unsigned long k = 1; k < nterms; ++k)
+    res = field_type::axb
+      (res, field_type::pow(x, terms[k - 1]._e - terms[k]._e), terms[k]._c);
+
+  return field_type::mul(res, field_type::pow(x, terms[nterms - 1]._e));
+}
+
+
+#endif // ! SPARSE_HH_INCLUDED
@@ -0,0 +1,546 @@
+#ifndef TAYLOR_HH_INCLUDED
+# define TAYLOR_HH_INCLUDED
+
+
+// taylor shift: the coefficients of q(y) = p(y + c), highest
+// degree first as everywhere else. only ring operations are
+// used, so that modp, whose modulus is not prime, is supported.
+//
+// small degrees: repeated synthetic division. p = q * (x - c) + r
+// gives p(y + c) = q(y + c) * y + r, ie. each deflate_par pass
+// yields the next lowest coefficient.
+//
+// large degrees: bottom up divide and conquer. with p = hi * x^s
+// + lo, p(x + c) = hi(x + c) * (x + c)^s + lo(x + c). blocks of
+// taylor_block_size coefficients are shifted by the classical
+// quadratic method, then pairs of adjacent blocks are merged
+// level by level with (x + c)^s, itself obtained by squarings.
+// products are karatsuba. a level is a set of independent
+// products: when there are fewer pairs than workers, the high
+// halves are cut in chunks so that the stealing runtime still
+// has enough products to balance, the chunk products being
+// summed back by a second parallel pass.
+//
+// internally, the coefficients are lowest degree first.
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "kaLinearWork.hh"
+#include "deflate.hh"
+
+
+static const unsigned long taylor_block_size = 64;
+static const unsigned long taylor_dc_threshold = 1024;
+static const unsigned long karatsuba_threshold = 32;
+
+// smallest chunk of a level product
+static const unsigned long taylor_min_chunk = 256;
+
+
+// scratch of a karatsuba product of size n: the level sums and
+// z1, then the scratch of the half size products, which run one
+// after the other
+
+static inline unsigned long karatsuba_scratch_size(unsigned long n)
+{
+  unsigned long size = 0;
+  for (; n > karatsuba_threshold; n -= n / 2) size += 4 * (n - n / 2) - 1;
+  return size;
+}
+
+// out[0, 2n - 1[ = a * b, a and b of n coefficients. scratch
+// has karatsuba_scratch_size(n) coefficients
+
+template<typename field_type>
+static void karatsuba
+(
+ const typename field_type::value_type* a,
+ const typename field_type::value_type* b,
+ unsigned long n, typename field_type::value_type* out,
+ typename field_type::value_type* scratch
+)
+{
+  typedef typename field_type::value_type value_type;
+
+  if (n <= karatsuba_threshold)
+  {
+    for (unsigned long i = 0; i < 2 * n - 1; ++i) out[i] = field_type::zero();
+    for (unsigned long i = 0; i < n; ++i)
+      for (unsigned long j = 0; j < n; ++j)
+	out[i + j] = field_type::axb(a[i], b[j], out[i + j]);
+    return ;
+  }
+
+  // a = a0 + a1 * x^m, a0 of m and a1 of h >= m coefficients
+  const unsigned long m = n / 2;
+  const unsigned long h = n - m;
+
+  value_type* const sa = scratch;
+  value_type* const sb = sa + h;
+  value_type* const z1 = sb + h;
+  value_type* const next = z1 + 2 * h - 1;
+
+  for (unsigned long i = 0; i < h; ++i)
+  {
+    sa[i] = i < m ? field_type::add(a[i], a[m + i]) : a[m + i];
+    sb[i] = i < m ? field_type::add(b[i], b[m + i]) : b[m + i];
+  }
+
+  // z0 in out[0, 2m - 1[, z2 in out[2m, 2n - 1[
+  karatsuba<field_type>(a, b, m, out, next);
+  out[2 * m - 1] = field_type::zero();
+  karatsuba<field_type>(a + m, b + m, h, out + 2 * m, next);
+
+  // z1 = (a0 + a1) * (b0 + b1) - z0 - z2
+  karatsuba<field_type>(sa, sb, h, z1, next);
+  for (unsigned long i = 0; i < 2 * m - 1; ++i)
+    z1[i] = field_type::sub(z1[i], out[i]);
+  for (unsigned long i = 0; i < 2 * h - 1; ++i)
+    z1[i] = field_type::sub(z1[i], out[2 * m + i]);
+
+  for (unsigned long i = 0; i < 2 * h - 1; ++i)
+    out[m + i] = field_type::add(out[m + i], z1[i]);
+}
+
+// scratch of poly_mul_seq: a product, a padded piece and the
+// karatsuba scratch, n being the smallest size
+
+static inline unsigned long poly_mul_scratch_size
+(unsigned long na, unsigned long nb)
+{
+  const unsigned long n = na < nb ? na : nb;
+  return 2 * n - 1 + n + karatsuba_scratch_size(n);
+}
+
+// out[0, na + nb - 1[ = a * b, cut in balanced karatsuba products.
+// scratch has poly_mul_scratch_size(na, nb) coefficients
+
+template<typename field_type>
+static void poly_mul_seq
+(
+ const typename field_type::value_type* a, unsigned long na,
+ const typename field_type::value_type* b, unsigned long nb,
+ typename field_type::value_type* out,
+ typename field_type::value_type* scratch
+)
+{
+  typedef typename field_type::value_type value_type;
+
+  if (na > nb)
+  {
+    poly_mul_seq<field_type>(b, nb, a, na, out, scratch);
+    return ;
+  }
+
+  for (unsigned long i = 0; i < na + nb - 1; ++i) out[i] = field_type::zero();
+
+  value_type* const tmp = scratch;
+  value_type* const pad = tmp + 2 * na - 1;
+
+  for (unsigned long o = 0; o < nb; o += na)
+  {
+    const unsigned long l = nb - o < na ? nb - o : na;
+
+    const value_type* piece = b + o;
+    if (l < na)
+    {
+      for (unsigned long i = 0; i < na; ++i)
+	pad[i] = i < l ? b[o + i] : field_type::zero();
+      piece = pad;
+    }
+
+    karatsuba<field_type>(a, piece, na, tmp, pad + na);
+    for (unsigned long i = 0; i < na + l - 1; ++i)
+      out[o + i] = field_type::add(out[o + i], tmp[i]);
+  }
+}
+
+// in place classical shift, lowest degree first
+
+template<typename field_type>
+static void taylor_shift_block
+(typename field_type::value_type c, typename field_type::value_type* a,
+ unsigned long size)
+{
+  for (unsigned long i = 0; i + 1 < size; ++i)
+    for (unsigned long j = size - 1; j > i; --j)
+      a[j - 1] = field_type::axb(c, a[j], a[j - 1]);
+}
+
+
+// shift the blocks of a level 0 buffer
+
+template<typename field_type>
+class taylorBlockWork : public ka::linearWork::baseWork
+{
+  // the work index j shifts the block j
+
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef ka::linearWork::voidResult result_type;
+  typedef typename field_type::value_type value_type;
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 1;
+  static const unsigned int par_grain = 1;
+
+  value_type _c;
+  value_type* _a;
+
+  taylorBlockWork(value_type c, value_type* a, unsigned long nblocks)
+    : baseWork(0, nblocks), _c(c), _a(a) {}
+
+  void initialize(const taylorBlockWork& w)
+  {
+    _c = w._c;
+    _a = w._a;
+  }
+
+  void execute(result_type&, const range_type& r)
+  {
+    for (range_type::index_type j = r.begin(); j < r.end(); ++j)
+      taylor_shift_block<field_type>
+	(_c, _a + j * taylor_block_size, taylor_block_size);
+  }
+
+  void reduce(result_type&, const result_type&, const range_type&) {}
+
+};
+
+
+// a set of independent products, each into its own buffer
+
+template<typename field_type>
+struct taylorProduct
+{
+  typedef typename field_type::value_type value_type;
+
+  const value_type* _a;
+  unsigned long _na;
+  const value_type* _b;
+  unsigned long _nb;
+
+  // _na + _nb - 1 coefficients
+  value_type* _out;
+
+  // position of _out[0] in the merged block
+  unsigned long _offset;
+};
+
+template<typename field_type>
+class taylorProductWork : public ka::linearWork::baseWork
+{
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef ka::linearWork::voidResult result_type;
+  typedef typename field_type::value_type value_type;
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 1;
+  static const unsigned int par_grain = 1;
+
+  const taylorProduct<field_type>* _products;
+
+  // product scratch, grown to the largest product executed
+  value_type* _scratch;
+  unsigned long _scratch_size;
+
+  taylorProductWork
+  (const taylorProduct<field_type>* products, unsigned long nproducts)
+    : baseWork(0, nproducts), _products(products),
+      _scratch(NULL), _scratch_size(0) {}
+
+  void initialize(const taylorProductWork& w)
+  {
+    _products = w._products;
+    _scratch = NULL;
+    _scratch_size = 0;
+  }
+
+  void finalize()
+  {
+    free(_scratch);
+    _scratch = NULL;
+    _scratch_size = 0;
+  }
+
+  void execute(result_type&, const range_type& r)
+  {
+    for (range_type::index_type k = r.begin(); k < r.end(); ++k)
+    {
+      const taylorProduct<field_type>& p = _products[k];
+
+      const unsigned long size = poly_mul_scratch_size(p._na, p._nb);
+      if (size > _scratch_size)
+      {
+	free(_scratch);
+	_scratch = (value_type*)malloc(size * sizeof(value_type));
+	_scratch_size = size;
+      }
+
+      poly_mul_seq<field_type>(p._a, p._na, p._b, p._nb, p._out, _scratch);
+    }
+  }
+
+  void reduce(result_type&, const result_type&, const range_type&) {}
+
+};
+
+
+// merged blocks: out[j * block + l] = lo[j * block + l], if l is
+// below lo_size, plus the products of the block j overlapping l.
+// a block has nper consecutive products.
+
+template<typename field_type>
+class taylorSumWork : public ka::linearWork::baseWork
+{
+public:
+
+  typedef ka::linearWork::range range_type;
+  typedef ka::linearWork::voidResult result_type;
+  typedef typename field_type::value_type value_type;
+
+  static const bool is_reducable = false;
+  static const unsigned int seq_grain = 1024;
+  static const unsigned int par_grain = 1024;
+
+  const value_type* _lo;
+  unsigned long _lo_size;
+  const taylorProduct<field_type>* _products;
+  unsigned long _nper;
+  unsigned long _block;
+  value_type* _out;
+
+  taylorSumWork
+  (const value_type* lo, unsigned long lo_size,
+   const taylorProduct<field_type>* products, unsigned long nper,
+   unsigned long block, unsigned long nblocks, value_type* out)
+    : baseWork(0, block * nblocks), _lo(lo), _lo_size(lo_size),
+      _products(products), _nper(nper), _block(block), _out(out) {}
+
+  void initialize(const taylorSumWork& w)
+  {
+    _lo = w._lo;
+    _lo_size = w._lo_size;
+    _products = w._products;
+    _nper = w._nper;
+    _block = w._block;
+    _out = w._out;
+  }
+
+  void execute(result_type&, const range_type& r)
+  {
+    for (range_type::index_type i = r.begin(); i < r.end(); ++i)
+    {
+      const unsigned long j = i / _block;
+      const unsigned long l = i % _block;
+
+      value_type v = field_type::zero();
+      if (_lo != NULL && l < _lo_size) v = _lo[i];
+
+      const taylorProduct<field_type>* const p = _products + j * _nper;
+      for (unsigned long t = 0; t < _nper; ++t)
+      {
+	const unsigned long size = p[t]._na + p[t]._nb - 1;
+	if (l >= p[t]._offset && l - p[t]._offset < size)
+	  v = field_type::add(v, p[t]._out[l - p[t]._offset]);
+      }
+
+      _out[i] = v;
+    }
+  }
+
+  void reduce(result_type&, const result_type&, const range_type&) {}
+
+};
+
+
+// chunks per product so that a level has enough of them
+
+static inline unsigned long taylor_nchunks
+(unsigned long nproducts, unsigned long size)
+{
+  const unsigned long nworkers = (unsigned long)kaapi_getconcurrency();
+  unsigned long nchunks = (2 * nworkers + nproducts - 1) / nproducts;
+  if (nchunks > size / taylor_min_chunk) nchunks = size / taylor_min_chunk;
+  return nchunks ? nchunks : 1;
+}
+
+// out[j * block, (j + 1) * block[ = lo_j + hi_j * b * x^hi_offset,
+// for the nblocks blocks. lo_j has lo_size coefficients at
+// lo + j * block, hi_j has nhi at his + j * block, b has nb.
+
+template<typename field_type>
+static void taylor_mul_add_par
+(
+ const typename field_type::value_type* lo, unsigned long lo_size,
+ const typename field_type::value_type* his, unsigned long nhi,
+ unsigned long hi_offset,
+ const typename field_type::value_type* b, unsigned long nb,
+ unsigned long block, unsigned long nblocks,
+ typename field_type::value_type* out
+)
+{
+  typedef typename field_type::value_type value_type;
+
+  // chunks of r coefficients, none empty
+  unsigned long nchunks = taylor_nchunks(nblocks, nhi);
+  const unsigned long r = (nhi + nchunks - 1) / nchunks;
+  nchunks = (nhi + r - 1) / r;
+
+  const unsigned long nproducts = nblocks * nchunks;
+
+  taylorProduct<field_type>* const products = (taylorProduct<field_type>*)
+    malloc(nproducts * sizeof(taylorProduct<field_type>));
+  value_type* const tmp = (value_type*)
+    malloc(nproducts * (r + nb - 1) * sizeof(value_type));
+
+  unsigned long k = 0;
+  for (unsigned long j = 0; j < nblocks; ++j)
+    for (unsigned long t = 0; t < nchunks; ++t, ++k)
+    {
+      taylorProduct<field_type>& p = products[k];
+      p._a = his + j * block + t * r;
+      p._na = nhi - t * r < r ? nhi - t * r : r;
+      p._b = b;
+      p._nb = nb;
+      p._out = tmp + k * (r + nb - 1);
+      p._offset = hi_offset + t * r;
+    }
+
+  taylorProductWork<field_type> work(products, nproducts);
+  ka::linearWork::execute(work);
+
+  taylorSumWork<field_type> sum
+    (lo, lo_size, products, nchunks, block, nblocks, out);
+  ka::linearWork::execute(sum);
+
+  free(products);
+  free(tmp);
+}
+
+
+// lowest degree first, size a multiple of taylor_block_size
+// times a power of 2. a is overwritten.
+
+template<typename field_type>
+static void taylor_shift_dc
+(typename field_type::value_type c, typename field_type::value_type* a,
+ unsigned long size)
+{
+  typedef typename field_type::value_type value_type;
+
+  taylorBlockWork<field_type> blocks(c, a, size / taylor_block_size);
+  ka::linearWork::execute(blocks);
+
+  if (size == taylor_block_size) return ;
+
+  value_type* const scratch = (value_type*)malloc(size * sizeof(value_type));
+  value_type* cur = a;
+  value_type* next = scratch;
+
+  // (x + c)^s, s the block size of the level. the first one is
+  // the shift of x^s.
+  unsigned long s = taylor_block_size;
+  value_type* pw = (value_type*)malloc((s + 1) * sizeof(value_type));
+  for (unsigned long i = 0; i < s; ++i) pw[i] = field_type::zero();
+  pw[s] = field_type::one();
+  taylor_shift_block<field_type>(c, pw, s + 1);
+
+  while (1)
+  {
+    // merge the pairs: next = lo + hi * (x + c)^s
+    taylor_mul_add_par<field_type>
+      (cur, s, cur + s, s, 0, pw, s + 1, 2 * s, size / (2 * s), next);
+
+    value_type* const t = cur;
+    cur = next;
+    next = t;
+
+    s *= 2;
+    if (s == size) break ;
+
+    value_type* const sq = (value_type*)malloc((s + 1) * sizeof(value_type));
+    taylor_mul_add_par<field_type>
+      (NULL, 0, pw, s / 2 + 1, 0, pw, s / 2 + 1, s + 1, 1, sq);
+    free(pw);
+    pw = sq;
+  }
+
+  if (cur != a) memcpy(a, cur, size * sizeof(value_type));
+
+  free(scratch);
+  free(pw);
+}
+
+
+template<typename field_type>
+static void taylor_shift_par
+(
+ typename field_type::value_type c,
+ const typename field_type::value_type* a, unsigned long n,
+ typename field_type::value_type* out
+)
+{
+  typedef typename field_type::value_type value_type;
+
+  if (n < taylor_dc_threshold)
+  {
+    value_type* cur = (value_type*)malloc((n + 1) * sizeof(value_type));
+    value_type* q = (value_type*)malloc((n + 1) * sizeof(value_type));
+    memcpy(cur, a, (n + 1) * sizeof(value_type));
+
+    // the remainder of the pass k is the degree k coefficient
+    for (unsigned long k = 0; k < n; ++k)
+    {
+      out[n - k] = deflate_par<field_type>(c, cur, n - k, q);
+      value_type* const t = cur;
+      cur = q;
+      q = t;
+    }
+    out[0] = cur[0];
+
+    free(cur);
+    free(q);
+    return ;
+  }
+
+  unsigned long size = taylor_block_size;
+  while (size < n + 1) size *= 2;
+
+  value_type* const tmp = (value_type*)malloc(size * sizeof(value_type));
+  for (unsigned long i = 0; i <= n; ++i) tmp[i] = a[n - i];
+  for (unsigned long i = n + 1; i < size; ++i) tmp[i] = field_type::zero();
+
+  taylor_shift_dc<field_type>(c, tmp, size);
+
+  // the padding shifts to zeros
+  for (unsigned long i = 0; i <= n; ++i) out[i] = tmp[n - i];
+
+  free(tmp);
+}
+
+template<typename field_type>
+static void taylor_shift_seq
+(
+ typename field_type::value_type c,
+ const typename field_type::value_type* a, unsigned long n,
+ typename field_type::value_type* out
+)
+{
+  typedef typename field_type::value_type value_type;
+
+  value_type* const tmp = (value_type*)malloc((n + 1) * sizeof(value_type));
+  for (unsigned long i = 0; i <= n; ++i) tmp[i] = a[n - i];
+
+  taylor_shift_block<field_type>(c, tmp, n + 1);
+
+  for (unsigned long i = 0; i <= n; ++i) out[i] = tmp[n - i];
+  free(tmp);
+}
+
+
+#endif // ! TAYLOR_HH_INCLUDED
@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include "taylor.hh"
+
+
+// taylor shift of random polynoms, against the classical method
+
+
+template<typename field_type>
+static unsigned long check
+(
+ unsigned long n, typename field_type::value_type c,
+ typename field_type::value_type (*rand_value)(), double& par_time
+)
+{
+  typedef typename field_type::value_type value_type;
+
+  value_type* const a = (value_type*)malloc((n + 1) * sizeof(value_type));
+  value_type* const res = (value_type*)malloc((n + 1) * sizeof(value_type));
+  value_type* const ref = (value_type*)malloc((n + 1) * sizeof(value_type));
+
+  for (unsigned long i = 0; i <= n; ++i) a[i] = rand_value();
+
+  taylor_shift_seq<field_type>(c, a, n, ref);
+
+  const uint64_t start = kaapi_get_elapsedns();
+  taylor_shift_par<field_type>(c, a, n, res);
+  const uint64_t stop = kaapi_get_elapsedns();
+  par_time = (double)(stop - start) / 1E6;
+
+  // the shifted coefficients grow, compare to the largest
+  double max = 0.;
+  for (unsigned long i = 0; i <= n; ++i)
+    if (fabs((double)ref[i]) > max) max = fabs((double)ref[i]);
+
+  unsigned long nerr = 0;
+  for (unsigned long i = 0; i <= n; ++i)
+    if (fabs((double)res[i] - (double)ref[i]) > 1E-9 * max) ++nerr;
+
+  free(a);
+  free(res);
+  free(ref);
+
+  return nerr;
+}
+
+static unsigned long rand_modp() { return modp(rand()); }
+static double rand_double() { return (double)rand() / RAND_MAX - 0.5; }
+
+int main(int ac, char** av)
+{
+  static const unsigned long ns[] = { 100, 1000, 5000, 32 * 1024 };
+
+  ka::linearWork::toRemove::initialize();
+
+  for (unsigned int k = 0; k < sizeof(ns) / sizeof(ns[0]); ++k)
+  {
+    double modp_time, double_time;
+    unsigned long nerr = 0;
+    nerr += check<modpField>(ns[k], 3, rand_modp, modp_time);
+    nerr += check<doubleField>(ns[k], 1E-3, rand_double, double_time);
+
+    printf("%u %lu %lf %lf %lu\n", kaapi_getconcurrency(), ns[k],
+	   modp_time, double_time, nerr);
+  }
+
+  ka::linearWork::toRemove::finalize();
+
+  return 0;
+}
@@ -5,6 +5,7 @@
 // parallel implementation
 
 #include "kaLinearWork.hh"
+#include "random.hh"
 
 class varWork;
 
@@ -122,7 +123,7 @@ int main(int ac, char** av)
   // generate a random vector
   const size_t n = 1024 * 1024;
   double* const x = (double*)malloc(n * sizeof(double));
-  for (size_t i = 0; i < n; ++i) x[i] = rand() % 100;
+  random_fill_par(x, n, 0, randomModulo<double>(100));
 
   uint64_t start = kaapi_get_elapsedns();
 
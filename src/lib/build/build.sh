@@ -0,0 +1,53 @@
+#!/usr/bin/env sh
+
+# builds libhorner.a and libhorner.so for any x86_64 machine.
+# kernel files get their own instruction set flags, the rest
+# the baseline. the parallel evaluator is built when the
+# runtime is installed, set HORNER_USE_XKAAPI=0 to disable.
+# ./build.sh install copies the library and header to PREFIX.
+# ./build.sh check runs the kernels against a plain horner.
+
+XKAAPI_DIR="$HOME/install/xkaapi_master"
+PREFIX="${PREFIX:-$HOME/install/horner}"
+
+CFLAGS="-Wall -O3 -fPIC"
+LFLAGS="-lm"
+
+if [ -z "$HORNER_USE_XKAAPI" ]; then
+    if [ -f "$XKAAPI_DIR/include/kaapi.h" ]; then
+	HORNER_USE_XKAAPI=1
+    else
+	HORNER_USE_XKAAPI=0
+    fi
+fi
+
+if [ "$HORNER_USE_XKAAPI" = 1 ]; then
+    CFLAGS="$CFLAGS -DHORNER_USE_XKAAPI=1 -I$XKAAPI_DIR/include"
+    LFLAGS="$LFLAGS -L$XKAAPI_DIR/lib -lkaapi -lpthread"
+fi
+
+set -e
+
+gcc $CFLAGS -msse2 -c -o kernel_sse2.o ../src/kernel_sse2.c
+gcc $CFLAGS -mavx2 -mfma -c -o kernel_avx2.o ../src/kernel_avx2.c
+gcc $CFLAGS -mavx512f -mfma -c -o kernel_avx512.o ../src/kernel_avx512.c
+gcc $CFLAGS -c -o horner.o ../src/horner.c
+
+OBJS="horner.o kernel_sse2.o kernel_avx2.o kernel_avx512.o"
+
+rm -f libhorner.a
+ar rcs libhorner.a $OBJS
+gcc -shared -o libhorner.so $OBJS $LFLAGS
+
+# static, the kernel tables are hidden in the shared library
+gcc $CFLAGS -o check ../src/check.c libhorner.a $LFLAGS
+
+if [ "$1" = check ]; then
+    LD_LIBRARY_PATH=$XKAAPI_DIR/lib:$LD_LIBRARY_PATH ./check
+fi
+
+if [ "$1" = install ]; then
+    mkdir -p "$PREFIX/include" "$PREFIX/lib"
+    cp ../src/horner.h "$PREFIX/include"
+    cp libhorner.a libhorner.so "$PREFIX/lib"
+fi
@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include "horner.h"
+#include "kernels.h"
+
+
+/* checks the library against a plain horner, for every
+   kernel table the machine supports. linked with the
+   static library, the kernel tables being internal.
+
+   output: one line per kernel table, name and number of
+   mismatches. returns 0 if there is none.
+ */
+
+
+#define CHECK_MAX_DEGREE (1UL << 12)
+
+/* points per polynom, one full group and a partial one */
+#define CHECK_NPOINTS 19
+
+/* large degrees, for the parallel path */
+static const unsigned long par_degrees[] = { 1UL << 16, 1UL << 20 };
+
+
+/* plain horner, and the bound of its error. the kernels
+   reorder the operations, results are not bitwise equal.
+ */
+
+static double plain_horner
+(double x, const double* a, unsigned long n, double* bound)
+{
+  double res = a[0];
+  double abs_res = fabs(a[0]);
+  unsigned long i;
+
+  for (i = 1; i <= n; ++i)
+  {
+    res = res * x + a[i];
+    abs_res = abs_res * fabs(x) + fabs(a[i]);
+  }
+
+  *bound = 4. * (double)(n + 1) * DBL_EPSILON * abs_res;
+  return res;
+}
+
+static double rand_unit(void)
+{
+  return 2. * (double)rand() / (double)RAND_MAX - 1.;
+}
+
+static unsigned long check_degree
+(const double* a, unsigned long n, const double* x, double* res)
+{
+  unsigned long nerr = 0;
+  double ref, bound;
+  unsigned int k;
+
+  horner_eval_points(x, CHECK_NPOINTS, a, n, res);
+
+  for (k = 0; k < CHECK_NPOINTS; ++k)
+  {
+    ref = plain_horner(x[k], a, n, &bound);
+    if (fabs(res[k] - ref) > bound) ++nerr;
+  }
+
+  ref = plain_horner(x[0], a, n, &bound);
+  if (fabs(horner_eval(x[0], a, n) - ref) > bound) ++nerr;
+  if (fabs(horner_eval_par(x[0], a, n) - ref) > bound) ++nerr;
+
+  return nerr;
+}
+
+static unsigned long check_kernels
+(const horner_kernels_t* kernels, const double* a, const double* x)
+{
+  unsigned long nerr = 0;
+  double res[CHECK_NPOINTS];
+  unsigned long n;
+  unsigned int i;
+
+  horner_kernels = kernels;
+
+  /* a + CHECK_MAX_DEGREE - n, the lowest degrees
+     of the largest polynom
+   */
+  for (n = 0; n <= CHECK_MAX_DEGREE; ++n)
+    nerr += check_degree(a + CHECK_MAX_DEGREE - n, n, x, res);
+
+  for (i = 0; i < sizeof(par_degrees) / sizeof(par_degrees[0]); ++i)
+  {
+    const unsigned long pn = par_degrees[i];
+    double* const pa = malloc((pn + 1) * sizeof(double));
+    double ref, bound;
+    unsigned long j;
+
+    for (j = 0; j <= pn; ++j) pa[j] = rand_unit();
+
+    ref = plain_horner(x[0], pa, pn, &bound);
+    if (fabs(horner_eval_par(x[0], pa, pn) - ref) > bound) ++nerr;
+
+    free(pa);
+  }
+
+  return nerr;
+}
+
+int main(int ac, char** av)
+{
+  const horner_kernels_t* const selected = horner_kernels;
+  double* const a = malloc((CHECK_MAX_DEGREE + 1) * sizeof(double));
+  double x[CHECK_NPOINTS];
+  unsigned long nerr = 0;
+  unsigned long i;
+
+  if (horner_init()) return -1;
+
+  srand(0);
+  for (i = 0; i <= CHECK_MAX_DEGREE; ++i) a[i] = rand_unit();
+  for (i = 0; i < CHECK_NPOINTS; ++i) x[i] = rand_unit();
+
+  __builtin_cpu_init();
+
+  {
+    const unsigned long e = check_kernels(&horner_kernels_sse2, a, x);
+    printf("sse2 %lu\n", e);
+    nerr += e;
+  }
+
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+  {
+    const unsigned long e = check_kernels(&horner_kernels_avx2, a, x);
+    printf("avx2 %lu\n", e);
+    nerr += e;
+  }
+
+  if (__builtin_cpu_supports("avx512f"))
+  {
+    const unsigned long e = check_kernels(&horner_kernels_avx512, a, x);
+    printf("avx512 %lu\n", e);
+    nerr += e;
+  }
+
+  horner_kernels = selected;
+
+  horner_finalize();
+  free(a);
+
+  return nerr ? -1 : 0;
+}
@@ -0,0 +1,256 @@
+#include <stdlib.h>
+#include <string.h>
+#include "horner.h"
+#include "kernels.h"
+
+
+/* kernel selection, at load time. the widest instruction
+   set the cpu supports, sse2 being the x86_64 baseline.
+ */
+
+const horner_kernels_t* horner_kernels = &horner_kernels_sse2;
+
+__attribute__((constructor))
+static void select_kernels(void)
+{
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx512f"))
+    horner_kernels = &horner_kernels_avx512;
+  else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    horner_kernels = &horner_kernels_avx2;
+  else
+    horner_kernels = &horner_kernels_sse2;
+}
+
+const char* horner_kernel_name(void)
+{
+  return horner_kernels->name;
+}
+
+
+/* degree to index translation routines
+ */
+
+inline static unsigned long to_degree
+(unsigned long i, unsigned long polynom_degree)
+{ return polynom_degree - i; }
+
+
+double horner_eval(double x, const double* a, unsigned long n)
+{
+  return horner_kernels->hilo(x, a, n, a[0], n, 0);
+}
+
+void horner_eval_points
+(const double* x, unsigned long m,
+ const double* a, unsigned long n, double* res)
+{
+  horner_kernels->points(x, m, a, n, res);
+}
+
+
+#if HORNER_USE_XKAAPI
+
+#include <math.h>
+#include "kaapi.h"
+
+
+/* xkaapi adaptive horner, see main.c. the work range
+   [0, n[ maps the index i to the coefficient a[i + 1].
+ */
+
+typedef struct master_work
+{
+  /* workqueue [i, j[ */
+  kaapi_workqueue_t wq;
+
+  const double* a;
+  unsigned long n;
+  double x;
+
+  double res;
+
+} master_work_t;
+
+typedef struct thief_work
+{
+  /* [i, j[ the range to process */
+  unsigned long i, j;
+
+  const double* a;
+  unsigned long n;
+  double x;
+
+  double res;
+
+  /* needed to avoid reducing twice */
+  unsigned long is_reduced;
+
+} thief_work_t;
+
+static void thief_entrypoint
+(void*, kaapi_thread_t*, kaapi_stealcontext_t*);
+
+static void common_reducer(master_work_t* vw, thief_work_t* tw)
+{
+  /* how much has been processed by the thief */
+  const unsigned long n = tw->i - (unsigned long)vw->wq.end;
+
+  vw->res = tw->res + vw->res * pow(vw->x, (double)n);
+
+  /* continue the thief work */
+  kaapi_workqueue_set(&vw->wq, tw->i, tw->j);
+}
+
+static int victim_reducer
+(kaapi_stealcontext_t* sc, void* targ, void* tdata, size_t tsize, void* varg)
+{
+  if (((thief_work_t*)tdata)->is_reduced == 0)
+    common_reducer(varg, tdata);
+  return 0;
+}
+
+/* do not steal ranges below */
+#define HORNER_PAR_GRAIN 4096
+
+/* sequential size to extract */
+#define HORNER_SEQ_GRAIN 1024
+
+/* below this degree, entering the adaptive
+   section costs more than the sequential loop
+ */
+#define HORNER_SEQ_THRESHOLD 16384
+
+static int splitter
+(kaapi_stealcontext_t* sc, int nreq, kaapi_request_t* req, void* args)
+{
+  master_work_t* const vw = (master_work_t*)args;
+
+  kaapi_workqueue_index_t i, j;
+  kaapi_workqueue_index_t range_size;
+  kaapi_workqueue_index_t unit_size;
+
+  int nrep = 0;
+
+ redo_steal:
+  range_size = kaapi_workqueue_size(&vw->wq);
+  if (range_size <= HORNER_PAR_GRAIN)
+    return 0;
+
+  unit_size = range_size / (nreq + 1);
+  if (unit_size == 0)
+  {
+    nreq = (range_size / HORNER_PAR_GRAIN) - 1;
+    unit_size = HORNER_PAR_GRAIN;
+  }
+
+  if (kaapi_workqueue_steal(&vw->wq, &i, &j, nreq * unit_size))
+    goto redo_steal;
+
+  for (; nreq; --nreq, ++req, ++nrep, j -= unit_size)
+  {
+    kaapi_taskadaptive_result_t* const ktr =
+      kaapi_allocate_thief_result(req, sizeof(thief_work_t), NULL);
+
+    thief_work_t* const tw = kaapi_reply_init_adaptive_task
+      (sc, req, (kaapi_task_body_t)thief_entrypoint, sizeof(thief_work_t), ktr);
+
+    tw->x = vw->x;
+    tw->a = vw->a;
+    tw->n = vw->n;
+    tw->i = j - unit_size;
+    tw->j = j;
+    tw->res = 0.;
+    tw->is_reduced = 0;
+
+    /* initialize ktr task may be preempted before entrypoint */
+    memcpy(ktr->data, tw, sizeof(thief_work_t));
+
+    kaapi_reply_pushhead_adaptive_task(sc, req);
+  }
+
+  return nrep;
+}
+
+static void thief_entrypoint
+(void* args, kaapi_thread_t* thread, kaapi_stealcontext_t* sc)
+{
+  thief_work_t* const work = (thief_work_t*)args;
+  thief_work_t* const res_work = kaapi_adaptive_result_data(sc);
+
+  work->res = horner_kernels->hilo
+    (work->x, work->a, work->n, work->res,
+     to_degree(work->i, work->n), to_degree(work->j, work->n));
+
+  work->i = work->j;
+
+  memcpy(res_work, work, sizeof(thief_work_t));
+}
+
+int horner_init(void)
+{
+  return kaapi_init();
+}
+
+void horner_finalize(void)
+{
+  kaapi_finalize();
+}
+
+double horner_eval_par(double x, const double* a, unsigned long n)
+{
+  static const unsigned long sc_flags =
+    KAAPI_SC_CONCURRENT | KAAPI_SC_PREEMPTION;
+
+  kaapi_thread_t* thread;
+  kaapi_taskadaptive_result_t* ktr;
+  kaapi_stealcontext_t* sc;
+  master_work_t work;
+  long i, j;
+
+  if (n <= HORNER_SEQ_THRESHOLD || kaapi_getconcurrency() == 1)
+    return horner_eval(x, a, n);
+
+  work.x = x;
+  work.a = a;
+  work.n = n;
+  work.res = a[0];
+  kaapi_workqueue_init(&work.wq, 0, n);
+
+  thread = kaapi_self_thread();
+  sc = kaapi_task_begin_adaptive(thread, sc_flags, splitter, &work);
+
+ continue_work:
+  while (kaapi_workqueue_pop(&work.wq, &i, &j, HORNER_SEQ_GRAIN) == 0)
+    work.res = horner_kernels->hilo
+      (x, a, n, work.res, to_degree(i, n), to_degree(j, n));
+
+  if ((ktr = kaapi_get_thief_head(sc)) != NULL)
+  {
+    kaapi_preempt_thief(sc, ktr, (void*)&work, victim_reducer, (void*)&work);
+    goto continue_work;
+  }
+
+  kaapi_task_end_adaptive(sc);
+
+  return work.res;
+}
+
+#else /* HORNER_USE_XKAAPI */
+
+int horner_init(void)
+{
+  return 0;
+}
+
+void horner_finalize(void)
+{
+}
+
+double horner_eval_par(double x, const double* a, unsigned long n)
+{
+  return horner_eval(x, a, n);
+}
+
+#endif /* HORNER_USE_XKAAPI */
@@ -0,0 +1,52 @@
+#ifndef HORNER_H_INCLUDED
+# define HORNER_H_INCLUDED
+
+
+/* libhorner: polynom evaluation in double precision.
+   coefficients are stored highest degree first, a[0]
+   being the degree n coefficient.
+
+   the kernels are built for several instruction sets
+   and the widest one supported by the machine is
+   selected when the library is loaded.
+ */
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* runtime setup. needed before horner_eval_par when
+   the library is built with the parallel runtime,
+   harmless otherwise. returns 0 on success.
+ */
+
+int horner_init(void);
+void horner_finalize(void);
+
+/* p(x), p of degree n */
+double horner_eval(double x, const double* a, unsigned long n);
+
+/* p(x), parallel when the library is built with
+   the parallel runtime, sequential otherwise
+ */
+double horner_eval_par(double x, const double* a, unsigned long n);
+
+/* res[k] = p(x[k]), k in [0, m[, in a single pass
+   over the coefficients
+ */
+void horner_eval_points
+(const double* x, unsigned long m,
+ const double* a, unsigned long n, double* res);
+
+/* name of the selected kernels: sse2, avx2 or avx512 */
+const char* horner_kernel_name(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* HORNER_H_INCLUDED */
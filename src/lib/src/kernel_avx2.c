@@ -0,0 +1,13 @@
+/* avx2 kernels, see the flags of build.sh
+ */
+
+#define HORNER_KERNEL(name) horner_ ## name ## _avx2
+#include "kernels.h"
+
+
+const horner_kernels_t horner_kernels_avx2 =
+{
+  "avx2",
+  horner_hilo_avx2,
+  horner_points_avx2
+};
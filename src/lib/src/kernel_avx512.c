@@ -0,0 +1,13 @@
+/* avx512 kernels, see the flags of build.sh
+ */
+
+#define HORNER_KERNEL(name) horner_ ## name ## _avx512
+#include "kernels.h"
+
+
+const horner_kernels_t horner_kernels_avx512 =
+{
+  "avx512",
+  horner_hilo_avx512,
+  horner_points_avx512
+};
@@ -0,0 +1,13 @@
+/* sse2 kernels, see the flags of build.sh
+ */
+
+#define HORNER_KERNEL(name) horner_ ## name ## _sse2
+#include "kernels.h"
+
+
+const horner_kernels_t horner_kernels_sse2 =
+{
+  "sse2",
+  horner_hilo_sse2,
+  horner_points_sse2
+};
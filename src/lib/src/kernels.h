@@ -0,0 +1,136 @@
+#ifndef KERNELS_H_INCLUDED
+# define KERNELS_H_INCLUDED
+
+
+/* kernels of one instruction set. a kernel file defines
+   HORNER_KERNEL(name) to suffix the names and includes
+   the kernel bodies, compiled with its own flags.
+ */
+
+
+typedef struct horner_kernels
+{
+  const char* name;
+
+  /* res * x^(hi - lo) + the degrees [lo, hi[ of p */
+  double (*hilo)
+  (double x, const double* a, unsigned long n,
+   double res, unsigned long hi, unsigned long lo);
+
+  void (*points)
+  (const double* x, unsigned long m,
+   const double* a, unsigned long n, double* res);
+
+} horner_kernels_t;
+
+/* internal to the library, not exported by the shared one */
+#define HORNER_HIDDEN __attribute__((visibility("hidden")))
+
+extern HORNER_HIDDEN const horner_kernels_t horner_kernels_sse2;
+extern HORNER_HIDDEN const horner_kernels_t horner_kernels_avx2;
+extern HORNER_HIDDEN const horner_kernels_t horner_kernels_avx512;
+
+/* the selected kernels */
+extern HORNER_HIDDEN const horner_kernels_t* horner_kernels;
+
+
+#endif /* KERNELS_H_INCLUDED */
+
+
+/* kernel bodies, included once per instruction set
+ */
+
+#ifdef HORNER_KERNEL
+
+#include <stddef.h>
+
+
+/* coefficients per block, kept in cache for all the points */
+#define HORNER_POINTS_BLOCK 1024
+
+/* points per group, one accumulator each */
+#define HORNER_POINTS_GROUP 16
+
+
+/* hybrid estrin: horner in x^8 over chunks of 8
+   coefficients, each chunk being an estrin tree.
+   a[n - d] is the degree d coefficient.
+ */
+
+static double HORNER_KERNEL(hilo)
+(
+ double x, const double* a, unsigned long n,
+ double res, unsigned long hi, unsigned long lo
+)
+{
+  const double x2 = x * x;
+  const double x4 = x2 * x2;
+  const double x8 = x4 * x4;
+
+  /* leading degrees, so that 8 divides hi - lo */
+  for (; (hi - lo) & 7; --hi)
+    res = res * x + a[n - (hi - 1)];
+
+  for (; hi > lo; hi -= 8)
+  {
+    /* p[k] the coefficient of the degree hi - 1 - k */
+    const double* const p = a + n - (hi - 1);
+
+    const double t0 = p[6] * x + p[7];
+    const double t1 = p[4] * x + p[5];
+    const double t2 = p[2] * x + p[3];
+    const double t3 = p[0] * x + p[1];
+
+    const double u0 = t1 * x2 + t0;
+    const double u1 = t3 * x2 + t2;
+
+    res = res * x8 + (u1 * x4 + u0);
+  }
+
+  return res;
+}
+
+static void HORNER_KERNEL(points)
+(
+ const double* x, unsigned long m,
+ const double* a, unsigned long n, double* res
+)
+{
+  unsigned long i0, i1, k, q, i;
+
+  for (k = 0; k < m; ++k) res[k] = a[0];
+
+  for (i0 = 1; i0 <= n; i0 = i1)
+  {
+    i1 = i0 + HORNER_POINTS_BLOCK;
+    if (i1 > n + 1) i1 = n + 1;
+
+    /* the point loops vectorize */
+    for (k = 0; k + HORNER_POINTS_GROUP <= m; k += HORNER_POINTS_GROUP)
+    {
+      double acc[HORNER_POINTS_GROUP];
+      double xs[HORNER_POINTS_GROUP];
+
+      for (q = 0; q < HORNER_POINTS_GROUP; ++q)
+      {
+	acc[q] = res[k + q];
+	xs[q] = x[k + q];
+      }
+
+      for (i = i0; i < i1; ++i)
+	for (q = 0; q < HORNER_POINTS_GROUP; ++q)
+	  acc[q] = acc[q] * xs[q] + a[i];
+
+      for (q = 0; q < HORNER_POINTS_GROUP; ++q) res[k + q] = acc[q];
+    }
+
+    for (; k < m; ++k)
+    {
+      double acc = res[k];
+      for (i = i0; i < i1; ++i) acc = acc * x[k] + a[i];
+      res[k] = acc;
+    }
+  }
+}
+
+#endif /* HORNER_KERNEL */
@@ -1,8 +1,33 @@
 #include <stdio.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
+
+
+/* estrin tree depth of the evaluation kernel
+ */
+
+#ifndef CONFIG_ESTRIN_DEPTH
+#define CONFIG_ESTRIN_DEPTH 3
+#endif
+
+/* the kernel switch has a case per depth up to 6 */
+#define CONFIG_ESTRIN_MAX_DEPTH 6
+
+#if CONFIG_ESTRIN_DEPTH > CONFIG_ESTRIN_MAX_DEPTH
+#error "CONFIG_ESTRIN_DEPTH > CONFIG_ESTRIN_MAX_DEPTH"
+#endif
+
+/* below this degree, entering the adaptive
+   section costs more than the sequential loop
+ */
+
+#ifndef CONFIG_SEQ_THRESHOLD
+#define CONFIG_SEQ_THRESHOLD 4096
+#endif
 
 
 /* this example implements arbitrary degree
@@ -10,6 +35,12 @@
    uses the horner scheme and a prefix algorithm
    for parallelization. sequential codes are
    provided for testing purposes.
+
+   ranges are evaluated by a hybrid estrin kernel:
+   horner in x^(2^depth) over chunks of 2^depth
+   coefficients, each chunk being an estrin tree.
+   the tree levels are independent multiply adds,
+   where horner is a single dependency chain.
  */
 
 
@@ -32,11 +63,27 @@ inline static unsigned long to_degree
 
 #include "kaapi.h"
 
+/* tree reduction: a finished thief absorbs the
+   finished results of the ranges that follow its
+   own, and the victim skips the absorbed ones.
+ */
+
+#ifndef CONFIG_TREE_REDUCE
+#define CONFIG_TREE_REDUCE 1
+#endif
+
+#define RES_RUNNING 0
+#define RES_DONE 1
+#define RES_ABSORBED 2
+
+
 /* work types and routines.
    master_work_t the parallel work.
    thief_work_t the stolen work.
  */
 
+struct thief_work;
+
 typedef struct master_work
 {
   /* workqueue [i, j[ */
@@ -52,6 +99,9 @@ typedef struct master_work
   /* result */
   double res;
 
+  /* the thief result following the range */
+  struct thief_work* next;
+
 } master_work_t;
 
 typedef struct thief_work
@@ -72,6 +122,10 @@ typedef struct thief_work
   /* needed to avoid reducing twice */
   unsigned long is_reduced;
 
+  /* tree reduction */
+  struct thief_work* next;
+  volatile unsigned long state;
+
 } thief_work_t;
 
 
@@ -80,8 +134,11 @@ typedef struct thief_work
 
 static void thief_entrypoint
 (void*, kaapi_thread_t*, kaapi_stealcontext_t*);
-static double horner_seq_hilo
-(double, const double*, unsigned long, double, unsigned long, unsigned long);
+static inline double estrin_seq_hilo
+(double, const double*, unsigned long, double,
+ unsigned long, unsigned long, unsigned int);
+static inline double estrin_seq
+(double, const double*, unsigned long, unsigned int);
 
 
 /* reduction.
@@ -98,7 +155,8 @@ static void common_reducer(master_work_t* vw, thief_work_t* tw)
 
   vw->res = tw->res + vw->res * pow(vw->x, (double)n);
 
-  /* continue the thief work */
+  /* continue the thief work, followed by its thieves results */
+  vw->next = tw->next;
   kaapi_workqueue_set(&vw->wq, tw->i, tw->j);
 }
 
@@ -120,6 +178,10 @@ static int victim_reducer
 {
   /* called from the victim to reduce a thief result */
 
+  /* absorbed by the thief of the previous range */
+  if (((thief_work_t*)tdata)->state == RES_ABSORBED)
+    return 0;
+
   if (((thief_work_t*)tdata)->is_reduced == 0)
   {
     /* not already reduced */
@@ -149,6 +211,9 @@ static int splitter
   /* size per request */
   kaapi_workqueue_index_t unit_size;
 
+  /* thieves are created from the highest range down */
+  thief_work_t* next;
+
  redo_steal:
   /* do not steal if range size <= PAR_GRAIN */
 #define CONFIG_PAR_GRAIN 256
@@ -170,6 +235,8 @@ static int splitter
   if (kaapi_workqueue_steal(&vw->wq, &i, &j, nreq * unit_size))
     goto redo_steal;
 
+  next = vw->next;
+
   for (; nreq; --nreq, ++req, ++nrep, j -= unit_size)
   {
     /* for reduction, a result is needed. take care of initializing it */
@@ -187,14 +254,20 @@ static int splitter
     tw->j = j;
     tw->res = 0.;
     tw->is_reduced = 0;
+    tw->next = next;
+    tw->state = RES_RUNNING;
 
     /* initialize ktr task may be preempted before entrypoint */
     memcpy(ktr->data, tw, sizeof(thief_work_t));
 
+    next = (thief_work_t*)ktr->data;
+
     /* reply head, preempt head */
     kaapi_reply_pushhead_adaptive_task(sc, req);
   }
 
+  vw->next = next;
+
   return nrep;
 }
 
@@ -227,14 +300,36 @@ static void thief_entrypoint
   const unsigned long hi = to_degree(work->i, work->n);
   const unsigned long lo = to_degree(work->j, work->n);
 
-  work->res = horner_seq_hilo
-    (work->x, work->a, work->n, work->res, hi, lo);
+  thief_work_t* next;
+
+  work->res = estrin_seq_hilo
+    (work->x, work->a, work->n, work->res, hi, lo, CONFIG_ESTRIN_DEPTH);
 
   /* update work indices */
   work->i = work->j;
 
+#if CONFIG_TREE_REDUCE
+  /* absorb the finished results that follow. a result
+     is only absorbed by the thief of the previous range,
+     which the victim preempts first.
+   */
+  while ((next = work->next) != NULL &&
+	 __sync_bool_compare_and_swap(&next->state, RES_DONE, RES_ABSORBED))
+  {
+    work->res = next->res + work->res * pow(work->x, (double)(next->i - work->i));
+    work->i = next->i;
+    work->j = next->j;
+    work->next = next->next;
+  }
+#endif
+
   /* we are finished, update results. */
   memcpy(res_work, work, sizeof(thief_work_t));
+
+#if CONFIG_TREE_REDUCE
+  __sync_synchronize();
+  res_work->state = RES_DONE;
+#endif
 }
 
 
@@ -258,11 +353,15 @@ static double horner_par
 
   master_work_t work;
 
+  if (n <= CONFIG_SEQ_THRESHOLD)
+    return estrin_seq(x, a, n, CONFIG_ESTRIN_DEPTH);
+
   /* initialize horner work */
   work.x = x;
   work.a = a;
   work.n = n;
   work.res = a[to_index(n, n)];
+  work.next = NULL;
   kaapi_workqueue_init(&work.wq, 0, n);
 
   /* enter adaptive section */
@@ -273,7 +372,8 @@ static double horner_par
   {
     const unsigned long hi = to_degree(i, n);
     const unsigned long lo = to_degree(j, n);
-    work.res = horner_seq_hilo(x, a, n, work.res, hi, lo);
+    work.res = estrin_seq_hilo
+      (x, a, n, work.res, hi, lo, CONFIG_ESTRIN_DEPTH);
   }
 
   /* preempt and reduce thieves */
@@ -289,6 +389,224 @@ static double horner_par
   return work.res;
 }
 
+
+/* deterministic parallel horner. the range is cut in
+   blocks whose boundaries depend on n only. a block is
+   evaluated from 0 by a single worker and stored, then
+   the block values are combined in a fixed tree order.
+   the result bits do not depend on the steals nor on
+   the number of workers. steals are in whole blocks.
+ */
+
+/* minimum block size, and maximum block count */
+#define CONFIG_DET_BLOCK 4096
+#define CONFIG_DET_MAX_BLOCKS 1024
+
+typedef struct det_work
+{
+  /* workqueue of blocks [i, j[ */
+  kaapi_workqueue_t wq;
+
+  /* polynom */
+  const double* a;
+  unsigned long n;
+
+  /* the point to evaluate */
+  double x;
+
+  /* block size and values */
+  unsigned long block_size;
+  double* values;
+
+} det_work_t;
+
+typedef struct det_res
+{
+  /* [i, j[ the blocks remaining */
+  unsigned long i, j;
+
+} det_res_t;
+
+static void det_thief_entrypoint
+(void*, kaapi_thread_t*, kaapi_stealcontext_t*);
+
+static unsigned long det_block_size(unsigned long n)
+{
+  const unsigned long size =
+    (n + CONFIG_DET_MAX_BLOCKS - 1) / CONFIG_DET_MAX_BLOCKS;
+  return size < CONFIG_DET_BLOCK ? CONFIG_DET_BLOCK : size;
+}
+
+/* values of the blocks [i, j[ */
+static void det_blocks(det_work_t* w, unsigned long i, unsigned long j)
+{
+  for (; i < j; ++i)
+  {
+    const unsigned long lo_index = i * w->block_size;
+    unsigned long hi_index = lo_index + w->block_size;
+    if (hi_index > w->n) hi_index = w->n;
+
+    w->values[i] = estrin_seq_hilo
+      (w->x, w->a, w->n, 0.,
+       to_degree(lo_index, w->n), to_degree(hi_index, w->n),
+       CONFIG_ESTRIN_DEPTH);
+  }
+}
+
+/* pairwise tree, values[0] * x^lens[0] + ... */
+static double det_combine
+(double x, const double* a, unsigned long n,
+ double* values, unsigned long* lens, unsigned long nblocks)
+{
+  unsigned long b, step;
+
+  for (step = 1; step < nblocks; step *= 2)
+    for (b = 0; b + step < nblocks; b += 2 * step)
+    {
+      values[b] = values[b] * pow(x, (double)lens[b + step]) + values[b + step];
+      lens[b] += lens[b + step];
+    }
+
+  return a[to_index(n, n)] * pow(x, (double)n) + values[0];
+}
+
+static int det_victim_reducer
+(kaapi_stealcontext_t* sc, void* targ, void* tdata, size_t tsize, void* varg)
+{
+  /* values are stored, continue the thief blocks */
+  det_work_t* const vw = (det_work_t*)varg;
+  det_res_t* const tr = (det_res_t*)tdata;
+  kaapi_workqueue_set(&vw->wq, tr->i, tr->j);
+  return 0;
+}
+
+static int det_splitter
+(kaapi_stealcontext_t* sc, int nreq, kaapi_request_t* req, void* args)
+{
+  det_work_t* const vw = (det_work_t*)args;
+
+  kaapi_workqueue_index_t i, j;
+  kaapi_workqueue_index_t range_size;
+  kaapi_workqueue_index_t unit_size;
+
+  int nrep = 0;
+
+ redo_steal:
+  range_size = kaapi_workqueue_size(&vw->wq);
+  if (range_size <= 1)
+    return 0;
+
+  unit_size = range_size / (nreq + 1);
+  if (unit_size == 0)
+  {
+    nreq = range_size - 1;
+    unit_size = 1;
+  }
+
+  if (kaapi_workqueue_steal(&vw->wq, &i, &j, nreq * unit_size))
+    goto redo_steal;
+
+  for (; nreq; --nreq, ++req, ++nrep, j -= unit_size)
+  {
+    kaapi_taskadaptive_result_t* const ktr =
+      kaapi_allocate_thief_result(req, sizeof(det_res_t), NULL);
+
+    det_work_t* const tw = kaapi_reply_init_adaptive_task
+      (sc, req, (kaapi_task_body_t)det_thief_entrypoint,
+       sizeof(det_work_t), ktr);
+
+    tw->a = vw->a;
+    tw->n = vw->n;
+    tw->x = vw->x;
+    tw->block_size = vw->block_size;
+    tw->values = vw->values;
+    kaapi_workqueue_init(&tw->wq, j - unit_size, j);
+
+    ((det_res_t*)ktr->data)->i = j - unit_size;
+    ((det_res_t*)ktr->data)->j = j;
+
+    kaapi_reply_pushhead_adaptive_task(sc, req);
+  }
+
+  return nrep;
+}
+
+static void det_thief_entrypoint
+(void* args, kaapi_thread_t* thread, kaapi_stealcontext_t* sc)
+{
+  det_work_t* const work = (det_work_t*)args;
+  det_res_t* const res = kaapi_adaptive_result_data(sc);
+
+  det_blocks(work, (unsigned long)work->wq.beg, (unsigned long)work->wq.end);
+
+  /* nothing remaining */
+  res->i = (unsigned long)work->wq.end;
+  res->j = (unsigned long)work->wq.end;
+}
+
+static double horner_par_det
+(double x, const double* a, unsigned long n)
+{
+  static const unsigned long sc_flags =
+    KAAPI_SC_CONCURRENT | KAAPI_SC_PREEMPTION;
+
+  kaapi_thread_t* const thread = kaapi_self_thread();
+  kaapi_taskadaptive_result_t* ktr;
+  kaapi_stealcontext_t* sc;
+
+  det_work_t work;
+  unsigned long nblocks, b;
+  unsigned long* lens;
+  long i, j;
+  double res;
+
+  if (n == 0) return a[0];
+
+  work.x = x;
+  work.a = a;
+  work.n = n;
+  work.block_size = det_block_size(n);
+
+  nblocks = (n + work.block_size - 1) / work.block_size;
+  work.values = malloc(nblocks * sizeof(double));
+  lens = malloc(nblocks * sizeof(unsigned long));
+
+  for (b = 0; b < nblocks; ++b)
+    lens[b] = b + 1 == nblocks ? n - b * work.block_size : work.block_size;
+
+  kaapi_workqueue_init(&work.wq, 0, nblocks);
+
+  /* the same blocks and tree in any case */
+  if (nblocks == 1)
+  {
+    det_blocks(&work, 0, 1);
+    goto combine;
+  }
+
+  sc = kaapi_task_begin_adaptive(thread, sc_flags, det_splitter, &work);
+
+ continue_work:
+  while (kaapi_workqueue_pop(&work.wq, &i, &j, 1) == 0)
+    det_blocks(&work, (unsigned long)i, (unsigned long)j);
+
+  if ((ktr = kaapi_get_thief_head(sc)) != NULL)
+  {
+    kaapi_preempt_thief
+      (sc, ktr, (void*)&work, det_victim_reducer, (void*)&work);
+    goto continue_work;
+  }
+
+  kaapi_task_end_adaptive(sc);
+
+ combine:
+  res = det_combine(x, a, n, work.values, lens, nblocks);
+
+  free(lens);
+  free(work.values);
+
+  return res;
+}
+
 #endif /* CONFIG_USE_XKAAPI */
 
 
@@ -317,6 +635,122 @@ static inline double horner_seq
 }
 
 
+/* second order horner: 2 chains in x^2, one for
+   the even and one for the odd degrees
+ */
+
+static double horner2_seq_hilo
+(
+ double x, const double* a, unsigned long n,
+ double res, unsigned long hi, unsigned long lo
+)
+{
+  const double y = x * x;
+  double e, o;
+  unsigned long i;
+
+  /* even count of degrees */
+  if ((hi - lo) & 1)
+  {
+    res = res * x + a[to_index(hi - 1, n)];
+    --hi;
+  }
+
+  /* res leads the even chain */
+  for (e = res, o = 0., i = hi; i > lo; i -= 2)
+  {
+    o = o * y + a[to_index(i - 1, n)];
+    e = e * y + a[to_index(i - 2, n)];
+  }
+
+  return e + x * o;
+}
+
+static inline double horner2_seq
+(double x, const double* a, unsigned long n)
+{
+  double res = a[to_index(n, n)];
+  return horner2_seq_hilo(x, a, n, res, n, 0);
+}
+
+
+/* hybrid estrin, same interface as horner_seq_hilo.
+   depth 0 is horner. estrin_chunks is instanciated
+   per constant depth, so that the tree unrolls in
+   registers.
+ */
+
+static inline double estrin_chunks
+(
+ const double* xs, const double* a, unsigned long n,
+ double res, unsigned long hi, unsigned long lo,
+ const unsigned int depth
+)
+{
+  const unsigned long c = 1UL << depth;
+  double t[1UL << CONFIG_ESTRIN_MAX_DEPTH];
+  unsigned long i, k, m;
+  unsigned int l;
+
+  /* hi - lo is a multiple of c */
+  for (i = hi; i > lo; i -= c)
+  {
+    /* t[k] the coefficient of the degree i - c + k */
+    const double* const p = a + to_index(i - 1, n);
+    for (k = 0; k < c; ++k) t[k] = p[c - 1 - k];
+
+    /* pairwise levels */
+    for (l = 0, m = c; m > 1; ++l, m /= 2)
+      for (k = 0; k < m / 2; ++k)
+	t[k] = t[2 * k + 1] * xs[l] + t[2 * k];
+
+    res = res * xs[depth] + t[0];
+  }
+
+  return res;
+}
+
+static inline double estrin_seq_hilo
+(
+ double x, const double* a, unsigned long n,
+ double res, unsigned long hi, unsigned long lo,
+ unsigned int depth
+)
+{
+  /* xs[l] = x^(2^l) */
+  double xs[CONFIG_ESTRIN_MAX_DEPTH + 1];
+  unsigned int l;
+
+  /* xs is sized for CONFIG_ESTRIN_MAX_DEPTH */
+  if (depth > CONFIG_ESTRIN_MAX_DEPTH) depth = CONFIG_ESTRIN_MAX_DEPTH;
+
+  xs[0] = x;
+  for (l = 1; l <= depth; ++l) xs[l] = xs[l - 1] * xs[l - 1];
+
+  /* leading degrees, so that 2^depth divides hi - lo */
+  for (; (hi - lo) & ((1UL << depth) - 1); --hi)
+    res = res * x + a[to_index(hi - 1, n)];
+
+  switch (depth)
+  {
+  case 0: return horner_seq_hilo(x, a, n, res, hi, lo);
+  case 1: return estrin_chunks(xs, a, n, res, hi, lo, 1);
+  case 2: return estrin_chunks(xs, a, n, res, hi, lo, 2);
+  case 3: return estrin_chunks(xs, a, n, res, hi, lo, 3);
+  case 4: return estrin_chunks(xs, a, n, res, hi, lo, 4);
+  case 5: return estrin_chunks(xs, a, n, res, hi, lo, 5);
+  default: return estrin_chunks(xs, a, n, res, hi, lo, 6);
+  }
+}
+
+static inline double estrin_seq
+(double x, const double* a, unsigned long n, unsigned int depth)
+{
+  double res = a[to_index(n, n)];
+  return estrin_seq_hilo(x, a, n, res, n, 0, depth);
+}
+
+
 /* sequential naive implementation
  */
 
@@ -331,21 +765,114 @@ static double naive_seq
 }
 
 
-/* generate a random polynom of degree n
+/* counter based random coefficients, the same splitmix64
+   streams as the c++ drivers. the element i is a function of
+   the seed and i only, the data do not depend on the order
+   of the generation.
+ */
+
+static const uint64_t random_golden = 0x9e3779b97f4a7c15ULL;
+
+static inline uint64_t random_mix(uint64_t z)
+{
+  /* splitmix64 output function */
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static inline uint64_t random_key(uint64_t seed)
+{ return random_mix(seed + random_golden); }
+
+static inline uint64_t random_word(uint64_t key, unsigned long i)
+{ return random_mix(key + (uint64_t)(i + 1) * random_golden); }
+
+
+/* generate a random polynom of degree n, coefficients
+   in [0, 0.01[ with 53 random bits
  */
 
 static double* make_rand_polynom(unsigned long n)
 {
   double* const a = malloc((n + 1) * sizeof(double));
+  const uint64_t key = random_key(0);
 
   size_t i;
   for (i = 0; i <= n; ++i)
-    a[i] = (rand() % 10) / 1000.f;
-  
+    a[i] = (double)(random_word(key, i) >> 11) * (0.01 / 9007199254740992.);
+
   return a;
 }
 
 
+/* kernels benchmark. for each degree, the time per
+   evaluation in ns and the relative error against a
+   long double horner, for horner, second order horner
+   and estrin of depths 1 to CONFIG_ESTRIN_MAX_DEPTH.
+ */
+
+static double get_elapsedns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1E9 + (double)ts.tv_nsec;
+}
+
+static double rel_error(double res, long double ref)
+{
+  const long double d = (long double)res - ref;
+  return (double)(fabsl(d) / (ref == 0. ? 1. : fabsl(ref)));
+}
+
+static void bench_kernels(void)
+{
+  static const unsigned long degrees[] =
+    { 7, 31, 255, 4095, 65535, 1024 * 1024 - 1 };
+  static const unsigned long ndegrees =
+    sizeof(degrees) / sizeof(degrees[0]);
+
+  /* |x| < 1, the sums stay bounded */
+  static const double x = -0.999;
+
+  unsigned long k, i, iter, niters;
+  unsigned int depth;
+  double start, res = 0.;
+
+  for (k = 0; k < ndegrees; ++k)
+  {
+    const unsigned long n = degrees[k];
+    double* const a = make_rand_polynom(n);
+    long double ref = a[to_index(n, n)];
+
+    for (i = n; i > 0; --i)
+      ref = ref * (long double)x + a[to_index(i - 1, n)];
+
+    /* about 2^24 coefficients per kernel */
+    niters = (16UL * 1024 * 1024) / (n + 1) + 1;
+
+    start = get_elapsedns();
+    for (iter = 0; iter < niters; ++iter) res = horner_seq(x, a, n);
+    printf("%lu horner %lf %e\n", n,
+	   (get_elapsedns() - start) / niters, rel_error(res, ref));
+
+    start = get_elapsedns();
+    for (iter = 0; iter < niters; ++iter) res = horner2_seq(x, a, n);
+    printf("%lu horner2 %lf %e\n", n,
+	   (get_elapsedns() - start) / niters, rel_error(res, ref));
+
+    for (depth = 1; depth <= CONFIG_ESTRIN_MAX_DEPTH; ++depth)
+    {
+      start = get_elapsedns();
+      for (iter = 0; iter < niters; ++iter) res = estrin_seq(x, a, n, depth);
+      printf("%lu estrin%u %lf %e\n", n, depth,
+	     (get_elapsedns() - start) / niters, rel_error(res, ref));
+    }
+
+    free(a);
+  }
+}
+
+
 /* main
  */
 
@@ -357,6 +884,13 @@ int main(int ac, char** av)
   /* the point to evaluate */
   static const double x = 2.;
 
+  if (ac > 1 && strcmp(av[1], "bench") == 0)
+  {
+    bench_kernels();
+    free(a);
+    return 0;
+  }
+
 #if CONFIG_USE_XKAAPI
   kaapi_init();
 #endif
@@ -366,6 +900,41 @@ int main(int ac, char** av)
 	 horner_seq(x, a, n),
 	 horner_par(x, a, n));
 
+  /* deterministic mode: overhead against horner_par,
+     and bitwise equality of repeated evaluations
+   */
+  {
+    static const unsigned long det_n = 1024 * 1024;
+    static const unsigned long niters = 100;
+
+    /* |x| < 1, the sums stay bounded */
+    static const double det_x = 0.9999;
+
+    double* const det_a = make_rand_polynom(det_n);
+    double start, par_time, det_time;
+    double ref, res = 0.;
+    unsigned long iter, ndiffs = 0;
+
+    start = get_elapsedns();
+    for (iter = 0; iter < niters; ++iter) res += horner_par(det_x, det_a, det_n);
+    par_time = (get_elapsedns() - start) / (niters * 1E6);
+
+    ref = horner_par_det(det_x, det_a, det_n);
+
+    start = get_elapsedns();
+    for (iter = 0; iter < niters; ++iter)
+    {
+      res = horner_par_det(det_x, det_a, det_n);
+      if (memcmp(&res, &ref, sizeof(double))) ++ndiffs;
+    }
+    det_time = (get_elapsedns() - start) / (niters * 1E6);
+
+    printf("%lf %lf %lf %lu\n", par_time, det_time,
+	   (det_time - par_time) / par_time, ndiffs);
+
+    free(det_a);
+  }
+
 #if CONFIG_USE_XKAAPI
   kaapi_finalize();
 #endif
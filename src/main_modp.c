@@ -7,6 +7,15 @@
 #include "kaapi.h"
 
 
+/* below this degree, entering the adaptive
+   section costs more than the sequential loop
+ */
+
+#ifndef CONFIG_SEQ_THRESHOLD
+#define CONFIG_SEQ_THRESHOLD 4096
+#endif
+
+
 /* this example implements arbitrary degree
    polynom evaluation in a given point. it
    uses the horner scheme and a prefix algorithm
@@ -85,6 +94,21 @@ inline static unsigned long to_degree
 /* xkaapi adaptive horner
  */
 
+/* tree reduction: a finished thief absorbs the
+   finished results of the ranges that follow its
+   own, and the victim skips the absorbed ones.
+ */
+
+#ifndef CONFIG_TREE_REDUCE
+#define CONFIG_TREE_REDUCE 1
+#endif
+
+#define RES_RUNNING 0
+#define RES_DONE 1
+#define RES_ABSORBED 2
+
+struct horner_res;
+
 typedef struct horner_work
 {
   /* the range to process */
@@ -100,6 +124,9 @@ typedef struct horner_work
   /* the result */
   unsigned long res;
 
+  /* the thief result following the range */
+  struct horner_res* next;
+
 } horner_work_t;
 
 typedef struct horner_res
@@ -113,6 +140,10 @@ typedef struct horner_res
   /* needed to avoid reducing twice */
   unsigned long is_reduced;
 
+  /* tree reduction */
+  struct horner_res* next;
+  volatile unsigned long state;
+
 } horner_res_t;
 
 
@@ -126,6 +157,9 @@ static unsigned long horner_seq_hilo
 (unsigned long, const unsigned long*, unsigned long,
  unsigned long, unsigned long, unsigned long);
 
+static inline unsigned long horner_seq
+(unsigned long, const unsigned long*, unsigned long);
+
 
 /* reduction.
    the runtime may execute it either on the victim or thief. it
@@ -142,7 +176,8 @@ static void common_reducer(horner_work_t* vw, horner_res_t* tw)
   /* vw->res = tw->res + vw->res * x^n; */
   vw->res = axnb_modp(vw->res, vw->x, n, tw->res);
 
-  /* continue the thief work */
+  /* continue the thief work, followed by its thieves results */
+  vw->next = tw->next;
   kaapi_workqueue_set(&vw->wq, tw->i, tw->j);
 }
 
@@ -164,6 +199,10 @@ static int victim_reducer
 {
   /* called from the victim to reduce a thief result */
 
+  /* absorbed by the thief of the previous range */
+  if (((horner_res_t*)tdata)->state == RES_ABSORBED)
+    return 0;
+
   if (((horner_res_t*)tdata)->is_reduced == 0)
   {
     /* not already reduced */
@@ -193,6 +232,9 @@ static int splitter
   /* size per request */
   kaapi_workqueue_index_t unit_size;
 
+  /* thieves are created from the highest range down */
+  horner_res_t* next;
+
  redo_steal:
   /* do not steal if range size <= PAR_GRAIN */
 #define CONFIG_PAR_GRAIN 256
@@ -214,6 +256,8 @@ static int splitter
   if (kaapi_workqueue_steal(&vw->wq, &i, &j, nreq * unit_size))
     goto redo_steal;
 
+  next = vw->next;
+
   for (; nreq; --nreq, ++req, ++nrep, j -= unit_size)
   {
     /* for reduction, a result is needed. take care of initializing it */
@@ -227,6 +271,7 @@ static int splitter
     tw->a = vw->a;
     tw->n = vw->n;
     tw->x = vw->x;
+    tw->next = next;
     kaapi_workqueue_init(&tw->wq, j - unit_size, j);
 
     /* initialize ktr task may be preempted before entrypoint */
@@ -234,11 +279,17 @@ static int splitter
     ((horner_res_t*)ktr->data)->j = j;
     ((horner_res_t*)ktr->data)->res = 0;
     ((horner_res_t*)ktr->data)->is_reduced = 0;
+    ((horner_res_t*)ktr->data)->next = next;
+    ((horner_res_t*)ktr->data)->state = RES_RUNNING;
+
+    next = (horner_res_t*)ktr->data;
     
     /* reply head, preempt head */
     kaapi_reply_pushhead_adaptive_task(sc, req);
   }
 
+  vw->next = next;
+
   return nrep;
 }
 
@@ -275,6 +326,8 @@ static void thief_entrypoint
 
   unsigned int is_preempted;
 
+  horner_res_t* next;
+
   /* set the splitter for this task */
   kaapi_steal_setsplitter(sc, splitter, work);
 
@@ -292,6 +345,9 @@ static void thief_entrypoint
     res->i = (unsigned long)work->wq.beg;
     res->j = (unsigned long)work->wq.end;
 
+    /* the victim continues with the remaining range */
+    res->next = work->next;
+
     is_preempted = kaapi_preemptpoint
       (sc, thief_reducer, NULL, NULL, 0, NULL);
 
@@ -306,6 +362,29 @@ static void thief_entrypoint
    */
   res->i = work->wq.beg;
   res->j = work->wq.beg;
+
+#if CONFIG_TREE_REDUCE
+  /* no more steals, work->next is stable */
+  kaapi_steal_setsplitter(sc, NULL, NULL);
+  kaapi_synchronize_steal(sc);
+
+  /* absorb the finished results that follow. a result
+     is only absorbed by the thief of the previous range,
+     which the victim preempts first.
+   */
+  while ((next = work->next) != NULL &&
+	 __sync_bool_compare_and_swap(&next->state, RES_DONE, RES_ABSORBED))
+  {
+    res->res = axnb_modp(res->res, work->x, next->i - res->i, next->res);
+    res->i = next->i;
+    res->j = next->j;
+    work->next = next->next;
+  }
+
+  res->next = work->next;
+  __sync_synchronize();
+  res->state = RES_DONE;
+#endif
 }
 
 
@@ -329,11 +408,15 @@ static unsigned long horner_par
 
   horner_work_t work;
 
+  if (n <= CONFIG_SEQ_THRESHOLD)
+    return horner_seq(x, a, n);
+
   /* initialize horner work */
   work.x = x;
   work.a = a;
   work.n = n;
   work.res = a[to_index(n, n)];
+  work.next = NULL;
   kaapi_workqueue_init(&work.wq, 0, n);
 
   /* enter adaptive section */
@@ -407,14 +490,40 @@ static unsigned long naive_seq
 }
 
 
-/* generate a random polynom of degree n
+/* counter based random coefficients, the same splitmix64
+   streams as the c++ drivers. the element i is a function of
+   the seed and i only, the data do not depend on the order
+   of the generation.
+ */
+
+static const uint64_t random_golden = 0x9e3779b97f4a7c15ULL;
+
+static inline uint64_t random_mix(uint64_t z)
+{
+  /* splitmix64 output function */
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static inline uint64_t random_key(uint64_t seed)
+{ return random_mix(seed + random_golden); }
+
+static inline uint64_t random_word(uint64_t key, unsigned long i)
+{ return random_mix(key + (uint64_t)(i + 1) * random_golden); }
+
+
+/* generate a random polynom of degree n, coefficients
+   in [0, 1001[ by the high word of w * 1001
  */
 
 static unsigned long* make_rand_polynom(unsigned long n)
 {
   unsigned long* const a = malloc((n + 1) * sizeof(unsigned long));
+  const uint64_t key = random_key(0);
   size_t i;
-  for (i = 0; i <= n; ++i) a[i] = modp(rand());
+  for (i = 0; i <= n; ++i)
+    a[i] = (unsigned long)(((unsigned __int128)random_word(key, i) * 1001) >> 64);
   return a;
 }
 